@@ -19,13 +19,52 @@ extern "C" {
 /// Function pointer of a function returning a char and taking a char as parameter
 typedef char(*ioFuncPtr)(char);
 
+/// Function pointer of a function that outputs a block of chars and returns number of chars output
+typedef int(*ioWriteFuncPtr)(const char* pData, int len);
+
 
 /**
  * Sets the function used to output a char by printf() or stdio output functions
  * @param func	The function pointer to use to output a char
+ * @note  This also removes the function set by stdio_SetOutputWriteFunction()
  */
 void stdio_SetOutputCharFunction(ioFuncPtr func);
 
+/**
+ * Sets the function used to output a block of chars by printf() or stdio output functions.
+ * When set, this is used instead of the function set by stdio_SetOutputCharFunction()
+ * so an entire printf() or puts() is output with a single call to this function.
+ * @param func  The function pointer to use to output a block of chars
+ * @note  stdio_SetOutputCharFunction() should be called before this function
+ */
+void stdio_SetOutputWriteFunction(ioWriteFuncPtr func);
+
+/**
+ * Enables line buffering of stdio output for the calling FreeRTOS task.
+ * The output of this task is buffered until a newline is output, the buffer
+ * gets full, the task reads stdio input, or stdio_FlushOutput() is called.
+ * This also prevents output of different tasks to be mixed up within a line.
+ * @param size  The size of the line buffer
+ * @returns non-zero if the line buffer was enabled
+ * @note  This uses the FreeRTOS Application Task Tag of the calling task
+ */
+int stdio_EnableTaskLineBuffer(int size);
+
+/**
+ * Outputs a block of chars to stdout, which is the same as fwrite() to stdout
+ * but without going through the C library.  The data goes through the task's line
+ * buffer (if enabled) and then to the output function.
+ * @param pData The data to output
+ * @param len   The length of the data
+ */
+void stdio_Write(const char* pData, int len);
+
+/**
+ * Outputs the calling task's line buffer if line buffering was enabled
+ * by stdio_EnableTaskLineBuffer()
+ */
+void stdio_FlushOutput(void);
+
 /**
  * Sets the function used to input a char by scanf() or stdio input functions
  * @param func	The function pointer to use to get a char
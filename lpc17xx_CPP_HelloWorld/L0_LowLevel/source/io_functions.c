@@ -1,7 +1,12 @@
 #include <stddef.h>    		// size_t
+#include <stdlib.h>    		// malloc()
+#include <string.h>    		// memcpy(), memchr()
 #include "io_functions.h"   // printfFuncPtr
 #include "sysConfig.h" 		// #if USE_REDUCED_PRINTF
 #include "uart0_min.h"
+#include "LPC17xx.h"		// SCB->ICSR
+#include "FreeRTOS.h"
+#include "task.h"			// xTaskGetApplicationTaskTag()
 
 
 void printMessageUponCriticalSystemError(const char* pMsg)
@@ -13,23 +18,113 @@ void printMessageUponCriticalSystemError(const char* pMsg)
 
 
 
-static ioFuncPtr mOutputDevFuncPtr = 0; ///< Function pointer for output function
-static ioFuncPtr mInputDevFuncPtr = 0;  ///< Function pointer for input function
+static ioFuncPtr mOutputDevFuncPtr = 0; 		///< Function pointer for output function
+static ioWriteFuncPtr mOutputWriteFuncPtr = 0;	///< Function pointer for block output function
+static ioFuncPtr mInputDevFuncPtr = 0;  		///< Function pointer for input function
+
+/**
+ * Line buffer of a task that is set as the task's "Application Task Tag"
+ * The buffer memory is allocated right after this structure.
+ */
+typedef struct {
+	unsigned short size;	///< Size of the buffer
+	unsigned short used;	///< Number of chars in the buffer
+	char buffer[1];			///< The buffer memory
+} taskLineBufferType;
 
 void stdio_SetOutputCharFunction(ioFuncPtr func)
 {
 	mOutputDevFuncPtr = func;
+	mOutputWriteFuncPtr = 0;
+}
+void stdio_SetOutputWriteFunction(ioWriteFuncPtr func)
+{
+	mOutputWriteFuncPtr = func;
 }
 void stdio_SetInputCharFunction(ioFuncPtr func)
 {
 	mInputDevFuncPtr = func;
 }
 
+/**
+ * @returns the line buffer of the calling task, or NULL if the task didn't enable
+ *          the line buffer, or if the scheduler is not running, or if called from an ISR.
+ */
+static taskLineBufferType* getTaskLineBuffer(void)
+{
+	const unsigned int activeIsrNumber = (SCB->ICSR & 0x1FF);
+	if (0 != activeIsrNumber || taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
+	{
+		return 0;
+	}
+	return (taskLineBufferType*) xTaskGetApplicationTaskTag(0);
+}
+
+/**
+ * Outputs the data to the output device using the block output function
+ * if available, otherwise using the char output function.
+ */
+static void writeToOutputDevice(const char* pData, size_t len)
+{
+	if (0 != mOutputWriteFuncPtr)
+	{
+		mOutputWriteFuncPtr(pData, len);
+	}
+	else if (0 != mOutputDevFuncPtr)
+	{
+		size_t i = 0;
+		for (i = 0; i < len; i++)
+		{
+			mOutputDevFuncPtr(pData[i]);
+		}
+	}
+}
+
+static void flushLineBuffer(taskLineBufferType* pLineBuffer)
+{
+	if (pLineBuffer->used > 0)
+	{
+		writeToOutputDevice(pLineBuffer->buffer, pLineBuffer->used);
+		pLineBuffer->used = 0;
+	}
+}
+
+int stdio_EnableTaskLineBuffer(int size)
+{
+	taskLineBufferType* pLineBuffer = getTaskLineBuffer();
+	if (0 != pLineBuffer || taskSCHEDULER_RUNNING != xTaskGetSchedulerState() || size <= 0)
+	{
+		return (0 != pLineBuffer);
+	}
+
+	pLineBuffer = (taskLineBufferType*) malloc(sizeof(taskLineBufferType) + size);
+	if (0 != pLineBuffer)
+	{
+		pLineBuffer->size = size;
+		pLineBuffer->used = 0;
+		vTaskSetApplicationTaskTag(0, (pdTASK_HOOK_CODE) pLineBuffer);
+	}
+
+	return (0 != pLineBuffer);
+}
+
+void stdio_FlushOutput(void)
+{
+	taskLineBufferType* pLineBuffer = getTaskLineBuffer();
+	if (0 != pLineBuffer)
+	{
+		flushLineBuffer(pLineBuffer);
+	}
+}
+
 /**
  * stdio scanf and getchar at this file goes here to read a char
  */
 size_t _read(int file, void *ptr, size_t len)
 {
+	// Output any prompt sitting in our line buffer before we wait for input
+	stdio_FlushOutput();
+
 	if (0 != mInputDevFuncPtr)
 	{
 		char* pChar = (char*) ptr;
@@ -43,20 +138,44 @@ size_t _read(int file, void *ptr, size_t len)
 }
 
 /**
- * stdio printf and putchar at this file goes here to output a char
+ * stdio printf and putchar at this file goes here to output data
  */
 size_t _write(int file, const void *ptr, size_t len)
 {
-	if (0 != mOutputDevFuncPtr)
+	stdio_Write((const char*) ptr, len);
+	return len;
+}
+
+void stdio_Write(const char* pData, int len)
+{
+	taskLineBufferType* pLineBuffer = getTaskLineBuffer();
+
+	if (0 == pLineBuffer)
+	{
+		writeToOutputDevice(pData, len);
+	}
+	else
 	{
-		char* d = (char*)ptr;
-		for (int i=0; i < len; i++)
+		// Flush the buffer if the new data doesn't fit, and write data directly if it is too large
+		if (pLineBuffer->used + len > pLineBuffer->size)
 		{
-			mOutputDevFuncPtr(d[i]);
+			flushLineBuffer(pLineBuffer);
 		}
-	}
+		if (len >= pLineBuffer->size)
+		{
+			writeToOutputDevice(pData, len);
+		}
+		else
+		{
+			memcpy(pLineBuffer->buffer + pLineBuffer->used, pData, len);
+			pLineBuffer->used += len;
 
-	return len;
+			if (0 != memchr(pData, '\n', len))
+			{
+				flushLineBuffer(pLineBuffer);
+			}
+		}
+	}
 }
 
 
@@ -96,21 +215,37 @@ size_t _write(int file, const void *ptr, size_t len)
 #else
 #include <stdarg.h>
 
-static void printchar(char **str, int c)
+/**
+ * Size of the stack buffer used by printf() to collect the output before handing
+ * it off to _write() so printf() doesn't output one char at a time.
+ */
+#define PRINTF_STACK_BUFFER_SIZE	64
+
+/**
+ * Output of the print functions below.
+ * sprintf() sets pEnd to NULL and the output is unbounded.
+ * printf() points to a stack buffer, which is output when full and at the end.
+ */
+typedef struct {
+	char* pOut;		///< Current output position
+	char* pStart;	///< Start of the output buffer
+	char* pEnd;		///< End of the output buffer, or NULL if unbounded
+} printOutType;
+
+static void printchar(printOutType *out, int c)
 {
-	if (str)
+	if (out->pEnd && out->pOut >= out->pEnd)
 	{
-		**str = c;
-		++(*str);
+		_write(0, out->pStart, out->pOut - out->pStart);
+		out->pOut = out->pStart;
 	}
-	else
-		_write(0, &c, 1);
+	*(out->pOut)++ = c;
 }
 
 #define PAD_RIGHT 1
 #define PAD_ZERO 2
 
-static int prints(char **out, const char *string, int width, int pad)
+static int prints(printOutType *out, const char *string, int width, int pad)
 {
 	register int pc = 0, padchar = ' ';
 
@@ -152,7 +287,7 @@ static int prints(char **out, const char *string, int width, int pad)
 /* the following should be enough for 32 bit int */
 #define PRINT_BUF_LEN 12
 
-static int printi(char **out, int i, int b, int sg, int width, int pad, int letbase)
+static int printi(printOutType *out, int i, int b, int sg, int width, int pad, int letbase)
 {
 	char print_buf[PRINT_BUF_LEN];
 	register char *s;
@@ -201,9 +336,61 @@ static int printi(char **out, int i, int b, int sg, int width, int pad, int letb
 	return pc + prints(out, s, width, pad);
 }
 
-static int print(char **out, const char *format, va_list args)
+/**
+ * Prints a float with given number of decimals.  The integer part and the fraction
+ * part are separated and the fraction is scaled to an integer so no floating point
+ * division is needed.
+ */
+static int printfloat(printOutType *out, double fnum, int width, int pad, int decimals)
+{
+	static const unsigned int scale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+	char print_buf[2 * PRINT_BUF_LEN];
+	register char *s = print_buf + sizeof(print_buf) - 1;
+	register unsigned int intPart, fracPart;
+	register int i, neg = 0;
+
+	if (decimals > 6)
+		decimals = 6;
+	if (fnum < 0)
+	{
+		neg = 1;
+		fnum = -fnum;
+	}
+	if (!(fnum < 4294967040.0)) /* Out of 32-bit range, or NaN */
+		return prints(out, "ovf", width, pad);
+
+	intPart = (unsigned int) fnum;
+	fracPart = (unsigned int) ((fnum - intPart) * scale[decimals] + 0.5);
+	if (fracPart >= scale[decimals])
+	{
+		fracPart -= scale[decimals];
+		++intPart;
+	}
+
+	/* Build the string from right to left: fraction, decimal point, integer */
+	*s = '\0';
+	for (i = 0; i < decimals; i++)
+	{
+		*--s = (fracPart % 10) + '0';
+		fracPart /= 10;
+	}
+	if (decimals > 0)
+		*--s = '.';
+	do
+	{
+		*--s = (intPart % 10) + '0';
+		intPart /= 10;
+	} while (intPart);
+
+	if (neg)
+		*--s = '-';
+
+	return prints(out, s, width, pad);
+}
+
+static int print(printOutType *out, const char *format, va_list args)
 {
-	register int width, pad;
+	register int width, pad, precision;
 	register int pc = 0;
 	char scr[2];
 
@@ -213,6 +400,7 @@ static int print(char **out, const char *format, va_list args)
 		{
 			++format;
 			width = pad = 0;
+			precision = -1;
 			if (*format == '\0')
 				break;
 			if (*format == '%')
@@ -232,13 +420,22 @@ static int print(char **out, const char *format, va_list args)
 				width *= 10;
 				width += *format - '0';
 			}
+			if (*format == '.')
+			{
+				++format;
+				for (precision = 0; *format >= '0' && *format <= '9'; ++format)
+				{
+					precision *= 10;
+					precision += *format - '0';
+				}
+			}
 			if (*format == 's')
 			{
 				register char *s = (char *) va_arg( args, int );
 				pc += prints(out, s ? s : "(null)", width, pad);
 				continue;
 			}
-			if (*format == 'd')
+			if (*format == 'd' || *format == 'i')
 			{
 				pc += printi(out, va_arg( args, int ), 10, 1, width, pad, 'a');
 				continue;
@@ -253,11 +450,6 @@ static int print(char **out, const char *format, va_list args)
 				pc += printi(out, va_arg( args, int ), 16, 0, width, pad, 'A');
 				continue;
 			}
-			if (*format == 'i' || *format == 'd')
-			{
-				pc += printi(out, va_arg(args,int) , 10, 0, width, pad, 'a');
-				continue;
-			}
 			if (*format == 'u')
 			{
 				pc += printi(out, va_arg( args, unsigned int ), 10, 0, width, pad, 'a');
@@ -265,13 +457,7 @@ static int print(char **out, const char *format, va_list args)
 			}
 			if (*format == 'f')
 			{
-				/* Experimental floating point printf */
-				double fnum = va_arg( args, double );
-				int x = fnum;
-				pc += printi(out, fnum, 10, 0, width, pad, 'a');
-				x = (fnum - x) * 1000 * 1000;
-				pc += printi(out, fnum, 10, 0, width, pad, 'a');
-
+				pc += printfloat(out, va_arg( args, double ), width, pad, precision < 0 ? 6 : precision);
 				continue;
 			}
 			if (*format == 'c')
@@ -289,8 +475,14 @@ static int print(char **out, const char *format, va_list args)
 			++pc;
 		}
 	}
-	if (out)
-		**out = '\0';
+	if (out->pEnd)
+	{
+		_write(0, out->pStart, out->pOut - out->pStart);
+	}
+	else
+	{
+		*(out->pOut) = '\0';
+	}
 
 	va_end( args);
 	return pc;
@@ -298,14 +490,17 @@ static int print(char **out, const char *format, va_list args)
 
 int printf(const char *format, ...)
 {
+	char buffer[PRINTF_STACK_BUFFER_SIZE];
+	printOutType out = { buffer, buffer, buffer + sizeof(buffer) };
 	va_list args;
 
 	va_start( args, format);
-	return print(0, format, args);
+	return print(&out, format, args);
 }
 
-int sprintf(char *out, const char *format, ...)
+int sprintf(char *str, const char *format, ...)
 {
+	printOutType out = { str, str, 0 };
 	va_list args;
 
 	va_start( args, format);
@@ -313,4 +508,3 @@ int sprintf(char *out, const char *format, ...)
 }
 
 #endif
-
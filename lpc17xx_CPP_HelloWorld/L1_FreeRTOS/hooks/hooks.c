@@ -7,8 +7,13 @@
 void vApplicationIdleHook(void)
 {
 	// THIS FUNCTION MUST NOT BLOCK
+#if configUSE_TICKLESS_IDLE
+	// The idle task sleeps in portSUPPRESS_TICKS_AND_SLEEP() after this hook returns, so waiting
+	// here for the next tick would delay every idle period by a tick, and rarely reach it.
+#else
 	// Put CPU to IDLE here. RTOS will wake up CPU from OS timer interrupt.
 	__WFI(); // Wait for Event: Puts the CPU in low powered mode
+#endif
 }
 
 void vApplicationStackOverflowHook( xTaskHandle *pxTask, signed portCHAR *pcTaskName )
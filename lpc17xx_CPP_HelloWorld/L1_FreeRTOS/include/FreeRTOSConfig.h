@@ -72,6 +72,8 @@
 #define configUSE_MALLOC_FAILED_HOOK    1
 #define configCPU_CLOCK_HZ			    (DESIRED_CPU_CLOCK)
 #define configTICK_RATE_HZ			    ( 1000 )
+#define configUSE_TICKLESS_IDLE         1   /* Stop the tick interrupt while all tasks are blocked (see port.c) */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
 
 #define configMAX_PRIORITIES			( 4 )
 /* Assuming there are 4-5 priorities set above */
@@ -105,10 +107,12 @@
 #define configUSE_COUNTING_SEMAPHORES 	0
 #define configUSE_ALTERNATIVE_API 		0
 #define configCHECK_FOR_STACK_OVERFLOW	2
-#define configUSE_RECURSIVE_MUTEXES		0
+#define configUSE_RECURSIVE_MUTEXES		1	/* Used by I2C_Device_Base to group shadow register updates */
 #define configQUEUE_REGISTRY_SIZE		10
 #define configGENERATE_RUN_TIME_STATS	1
 #define configUSE_TRACE_FACILITY		1
+#define configUSE_APPLICATION_TASK_TAG	1	/* Used by io_functions.c for per-task stdio line buffer */
+#define configUSE_TASK_NOTIFICATIONS	1	/* Per task notification value used by drivers to wake up the waiting task */
 
 
 /* Set the following definitions to 1 to include the API function, or zero
@@ -121,6 +125,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	0
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
 
 
 /* Use the system definition, if there is one */
@@ -1159,6 +1159,72 @@ constant. */
 portBASE_TYPE xTaskCallApplicationTaskHook( xTaskHandle xTask, void *pvParameter ) PRIVILEGED_FUNCTION;
 
 
+/*-----------------------------------------------------------
+ * TASK NOTIFICATIONS
+ *----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+/* Actions performed on the notification value of the task being notified. */
+typedef enum
+{
+	eNoAction = 0,				/* Notify the task without changing its notification value. */
+	eSetBits,					/* Bitwise OR the value into the notification value. */
+	eIncrement,					/* Increment the notification value (the value is not used). */
+	eSetValueWithOverwrite,		/* Set the notification value even if the task did not read the previous value. */
+	eSetValueWithoutOverwrite	/* Set the notification value only if the task read the previous value. */
+} eNotifyAction;
+
+/*
+ * Each task has a 32-bit notification value, and a notification sent to a task
+ * unblocks the task if it is waiting for one.  This is a faster and lighter
+ * alternative to a binary or counting semaphore, or an event group, when the
+ * events are always sent to a single known task: no queue object needs to be
+ * created, and the notification is sent straight to the TCB.
+ *
+ * Sends a notification to pxTaskToNotify, and updates its notification value
+ * by eAction using ulValue.
+ *
+ * Returns pdFAIL only if eAction is eSetValueWithoutOverwrite and the task
+ * had a pending notification, otherwise pdPASS.
+ */
+portBASE_TYPE xTaskNotify( xTaskHandle pxTaskToNotify, unsigned long ulValue, eNotifyAction eAction ) PRIVILEGED_FUNCTION;
+
+/*
+ * Version of xTaskNotify() that can be used from an ISR.
+ * pxHigherPriorityTaskWoken is set to pdTRUE if the notified task has a
+ * higher priority than the interrupted task, in which case a context switch
+ * should be requested before the ISR exits.
+ */
+portBASE_TYPE xTaskNotifyFromISR( xTaskHandle pxTaskToNotify, unsigned long ulValue, eNotifyAction eAction, portBASE_TYPE *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/*
+ * Waits up to xTicksToWait for a notification.
+ *
+ * ulBitsToClearOnEntry are cleared from the notification value on entry if no
+ * notification was pending, and ulBitsToClearOnExit are cleared before
+ * returning if a notification was received.  The notification value before
+ * ulBitsToClearOnExit is cleared is saved to pulNotificationValue (if not NULL).
+ *
+ * Returns pdTRUE if a notification was received, or pdFALSE upon timeout.
+ */
+portBASE_TYPE xTaskNotifyWait( unsigned long ulBitsToClearOnEntry, unsigned long ulBitsToClearOnExit, unsigned long *pulNotificationValue, portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/*
+ * Lightweight binary or counting semaphore using the notification value as
+ * the count.  xTaskNotifyGive() and vTaskNotifyGiveFromISR() increment the
+ * count, and ulTaskNotifyTake() waits up to xTicksToWait for the count to be
+ * non-zero.  ulTaskNotifyTake() clears the count if xClearCountOnExit is
+ * pdTRUE (binary semaphore), otherwise it decrements it (counting semaphore),
+ * and returns the count before it was cleared or decremented, which is zero
+ * upon timeout.
+ */
+#define xTaskNotifyGive( pxTaskToNotify ) xTaskNotify( ( pxTaskToNotify ), 0, eIncrement )
+void vTaskNotifyGiveFromISR( xTaskHandle pxTaskToNotify, portBASE_TYPE *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+unsigned long ulTaskNotifyTake( portBASE_TYPE xClearCountOnExit, portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TASK_NOTIFICATIONS */
+
 /*-----------------------------------------------------------
  * SCHEDULER INTERNALS AVAILABLE FOR PORTING PURPOSES
  *----------------------------------------------------------*/
@@ -1175,6 +1241,32 @@ portBASE_TYPE xTaskCallApplicationTaskHook( xTaskHandle xTask, void *pvParameter
  */
 void vTaskIncrementTick( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
+ * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
+ * AN INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED.
+ *
+ * Called by portSUPPRESS_TICKS_AND_SLEEP() after the tick interrupt was
+ * stopped, to correct the tick count by the number of tick periods that
+ * elapsed while the processor was asleep.
+ */
+void vTaskStepTick( portTickType xTicksToJump ) PRIVILEGED_FUNCTION;
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
+ * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
+ * AN INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Called by portSUPPRESS_TICKS_AND_SLEEP() just before sleeping.  Returns
+ * pdFALSE if a task became ready to run after the idle task decided to sleep,
+ * in which case the sleep should be aborted.
+ */
+portBASE_TYPE xTaskConfirmSleepModeStatus( void ) PRIVILEGED_FUNCTION;
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
  * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
@@ -69,12 +69,14 @@ FreeRTOS.org versions prior to V4.4.0 did not include this definition. */
 /* Constants required to manipulate the NVIC. */
 #define portNVIC_SYSTICK_CTRL		( ( volatile unsigned long *) 0xe000e010 )
 #define portNVIC_SYSTICK_LOAD		( ( volatile unsigned long *) 0xe000e014 )
+#define portNVIC_SYSTICK_CURRENT	( ( volatile unsigned long *) 0xe000e018 )
 #define portNVIC_INT_CTRL			( ( volatile unsigned long *) 0xe000ed04 )
 #define portNVIC_SYSPRI2			( ( volatile unsigned long *) 0xe000ed20 )
 #define portNVIC_SYSTICK_CLK		0x00000004
 #define portNVIC_SYSTICK_INT		0x00000002
 #define portNVIC_SYSTICK_ENABLE		0x00000001
 #define portNVIC_PENDSVSET			0x10000000
+#define portNVIC_PENDSTSET			0x04000000
 #define portNVIC_PENDSV_PRI			( ( ( unsigned long ) configKERNEL_INTERRUPT_PRIORITY ) << 16 )
 #define portNVIC_SYSTICK_PRI		( ( ( unsigned long ) configKERNEL_INTERRUPT_PRIORITY ) << 24 )
 
@@ -298,12 +300,125 @@ void vConfigureTimerForRunTimeStats( void )
 	 */
 	LPC_TIM0->PR = (getCpuClock() * TIMER0_US_PER_TICK) / (1000*1000);
 }
+/**
+ * Run time stats are reset by remembering the TC value rather than clearing TC,
+ * because Timer0 TC is also the monotonic time base of systime.h
+ */
+static unsigned int ulRunTimeCounterOffset = 0;
 unsigned int uxGetTimerForRunTimeStats()
 {
-	return LPC_TIM0->TC;
+	return LPC_TIM0->TC - ulRunTimeCounterOffset;
 }
 void resetRunTimeCounter()
 {
-	LPC_TIM0->TC = 0;
+	ulRunTimeCounterOffset = LPC_TIM0->TC;
 }
 
+#if configUSE_TICKLESS_IDLE == 1
+/*
+ * Tickless idle uses Timer0 as the long period wake-up timer, because it keeps
+ * counting while the CPU sleeps and its 32-bit counter covers many seconds,
+ * whereas the 24-bit SysTick only covers 167ms at 100Mhz.  Timer0 match 2 wakes
+ * up the CPU when the next task is due, and the Timer0 count that elapsed
+ * (in CPU cycles using its prescale counter) corrects the tick count.  The run
+ * time statistics are based on Timer0 too, so the sleep time is still counted
+ * towards the idle task.
+ *
+ * The match interrupt can only wake up the CPU if TIMER0_IRQn is enabled in the
+ * NVIC, which is done by systime_Init() along with the TIMER0_IRQHandler() that
+ * tolerates this match.  Until then, the idle task sleeps only until the next tick.
+ */
+#define portTIMER0_MR2_INT			( 1UL << 6 )	/* MR2I bit of MCR */
+#define portTIMER0_MR2_FLAG			( 1UL << 2 )	/* MR2 bit of IR */
+
+/* Returns the Timer0 count in CPU cycles (wraps at 32-bits) */
+static unsigned long prvGetTimer0Cycles( unsigned long *pulTc, unsigned long *pulPc )
+{
+unsigned long ulTc, ulPc;
+
+	/* Read again if TC incremented while reading PC */
+	do
+	{
+		ulTc = LPC_TIM0->TC;
+		ulPc = LPC_TIM0->PC;
+	} while( ulTc != LPC_TIM0->TC );
+
+	*pulTc = ulTc;
+	*pulPc = ulPc;
+	return ( ulTc * ( LPC_TIM0->PR + 1 ) ) + ulPc;
+}
+
+void vPortSuppressTicksAndSleep( portTickType xExpectedIdleTime )
+{
+const unsigned long ulCyclesPerTick = configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+const portTickType xMaxIdleTime = 0x7FFFFFFFUL / ulCyclesPerTick;
+unsigned long ulRemainingCycles, ulSleepCycles, ulStartCycles, ulElapsedCycles, ulNextTickCycles;
+unsigned long ulTc, ulPc;
+portTickType xCompleteTicks;
+
+	/* Without the Timer0 interrupt, nothing would wake us up when the next task is due */
+	if( 0 == ( NVIC->ISER[ ( ( unsigned long ) TIMER0_IRQn ) >> 5 ] & ( 1UL << ( ( ( unsigned long ) TIMER0_IRQn ) & 0x1F ) ) ) )
+	{
+		__asm volatile( "wfi" );
+		return;
+	}
+
+	if( xExpectedIdleTime > xMaxIdleTime )
+	{
+		xExpectedIdleTime = xMaxIdleTime;
+	}
+
+	/* Stop the SysTick, the current value is the cycles until the next tick */
+	__asm volatile( "cpsid i" );
+	*(portNVIC_SYSTICK_CTRL) &= ~portNVIC_SYSTICK_ENABLE;
+	ulRemainingCycles = *(portNVIC_SYSTICK_CURRENT) + 1UL;
+
+	/* Abort if a task became ready, or a tick is already pending */
+	if( ( xTaskConfirmSleepModeStatus() == pdFALSE ) || ( *(portNVIC_INT_CTRL) & portNVIC_PENDSTSET ) )
+	{
+		*(portNVIC_SYSTICK_CTRL) |= portNVIC_SYSTICK_ENABLE;
+		__asm volatile( "cpsie i" );
+		return;
+	}
+
+	/* Sleep until the end of the tick before the next task unblocks */
+	ulSleepCycles = ulRemainingCycles + ( ( xExpectedIdleTime - 1UL ) * ulCyclesPerTick );
+	ulStartCycles = prvGetTimer0Cycles( &ulTc, &ulPc );
+	LPC_TIM0->IR = portTIMER0_MR2_FLAG;
+	LPC_TIM0->MR2 = ulTc + ( ( ulPc + ulSleepCycles ) / ( LPC_TIM0->PR + 1 ) );
+	LPC_TIM0->MCR |= portTIMER0_MR2_INT;
+
+	/* Any interrupt wakes up the CPU, but it only runs after interrupts are enabled */
+	__asm volatile( "dsb" );
+	__asm volatile( "wfi" );
+	__asm volatile( "isb" );
+
+	LPC_TIM0->MCR &= ~portTIMER0_MR2_INT;
+	LPC_TIM0->IR = portTIMER0_MR2_FLAG;
+
+	/* Count the complete tick periods, and restart the SysTick so that the
+	next tick occurs where it would have been had it not been stopped */
+	ulElapsedCycles = prvGetTimer0Cycles( &ulTc, &ulPc ) - ulStartCycles;
+	if( ulElapsedCycles < ulRemainingCycles )
+	{
+		xCompleteTicks = 0;
+		ulNextTickCycles = ulRemainingCycles - ulElapsedCycles;
+	}
+	else
+	{
+		ulElapsedCycles -= ulRemainingCycles;
+		xCompleteTicks = 1 + ( ulElapsedCycles / ulCyclesPerTick );
+		ulNextTickCycles = ulCyclesPerTick - ( ulElapsedCycles % ulCyclesPerTick );
+	}
+
+	*(portNVIC_SYSTICK_LOAD) = ( ulNextTickCycles > 1UL ) ? ( ulNextTickCycles - 1UL ) : 1UL;
+	*(portNVIC_SYSTICK_CURRENT) = 0UL;
+	*(portNVIC_SYSTICK_CTRL) |= portNVIC_SYSTICK_ENABLE;
+	vTaskStepTick( xCompleteTicks );
+
+	/* The SysTick already loaded the partial period, so this is used after the next tick */
+	*(portNVIC_SYSTICK_LOAD) = ulCyclesPerTick - 1UL;
+
+	__asm volatile( "cpsie i" );
+}
+#endif /* configUSE_TICKLESS_IDLE */
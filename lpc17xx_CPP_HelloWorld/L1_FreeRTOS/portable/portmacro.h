@@ -148,6 +148,12 @@ extern void vPortExitCritical( void );
 
 #define portNOP()
 
+/* Tickless idle */
+#if configUSE_TICKLESS_IDLE == 1
+	extern void vPortSuppressTicksAndSleep( portTickType xExpectedIdleTime );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -121,8 +121,18 @@ typedef struct tskTaskControlBlock
 		unsigned long ulRunTimeCounter;		/*< Used for calculating how much CPU time each task is utilising. */
 	#endif
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+		volatile unsigned long ulNotifiedValue;	/*< The notification value of the task. */
+		volatile unsigned char ucNotifyState;	/*< One of the taskNOTIFY_ states. */
+	#endif
+
 } tskTCB;
 
+/* Values of the ucNotifyState member of the TCB. */
+#define taskNOT_WAITING_NOTIFICATION	( ( unsigned char ) 0 )
+#define taskWAITING_NOTIFICATION		( ( unsigned char ) 1 )
+#define taskNOTIFICATION_RECEIVED		( ( unsigned char ) 2 )
+
 
 /*
  * Some kernel aware debuggers require data to be viewed to be global, rather
@@ -393,6 +403,36 @@ static void prvAddCurrentTaskToDelayedList( portTickType xTimeToWake ) PRIVILEGE
  */
 static tskTCB *prvAllocateTCBAndStack( unsigned short usStackDepth, portSTACK_TYPE *puxStackBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Used only by the idle task when tickless idle is enabled.  Returns the
+ * number of ticks until a task other than the idle task is expected to
+ * run, or zero if another task is already ready to run.
+ */
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	static portTickType prvGetExpectedIdleTime( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
+/*
+ * Used by the task notification functions.  Blocks the calling task until it
+ * is notified or xTicksToWait expires.  Must be called from a critical section.
+ */
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	static void prvBlockCurrentTaskForNotification( portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Updates the notification value of pxTCB and unblocks it if it is waiting
+	 * for a notification.  Must be called from a critical section or with
+	 * interrupts masked.  Returns pdFAIL if eAction is eSetValueWithoutOverwrite
+	 * and a notification was pending.  pxYieldRequired is set to pdTRUE if the
+	 * task was unblocked and has a higher priority than the current task.
+	 */
+	static portBASE_TYPE prvNotify( tskTCB *pxTCB, unsigned long ulValue, eNotifyAction eAction, portBASE_TYPE *pxYieldRequired ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Called from vTaskList.  vListTasks details all the tasks currently under
  * control of the scheduler.  The tasks may be in one of a number of lists.
@@ -1983,6 +2023,246 @@ void vTaskMissedYield( void )
 	xMissedYield = pdTRUE;
 }
 
+/*-----------------------------------------------------------
+ * Task notifications.
+ *----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	static void prvBlockCurrentTaskForNotification( portTickType xTicksToWait )
+	{
+		pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+
+		/* The task is only placed in the delayed (or suspended) list, and not
+		in an event list.  The notifying task or ISR moves it to the ready list
+		directly. */
+		vListRemove( ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+
+		#if ( INCLUDE_vTaskSuspend == 1 )
+		{
+			if( xTicksToWait == portMAX_DELAY )
+			{
+				vListInsertEnd( ( xList * ) &xSuspendedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+			}
+			else
+			{
+				prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+			}
+		}
+		#else
+		{
+			prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+		}
+		#endif
+
+		/* The yield happens when the critical section is exited. */
+		portYIELD_WITHIN_API();
+	}
+	/*-----------------------------------------------------------*/
+
+	static portBASE_TYPE prvNotify( tskTCB *pxTCB, unsigned long ulValue, eNotifyAction eAction, portBASE_TYPE *pxYieldRequired )
+	{
+	portBASE_TYPE xReturn = pdPASS;
+	unsigned char ucOriginalState;
+
+		ucOriginalState = pxTCB->ucNotifyState;
+
+		switch( eAction )
+		{
+			case eSetBits:
+				pxTCB->ulNotifiedValue |= ulValue;
+				break;
+
+			case eIncrement:
+				( pxTCB->ulNotifiedValue )++;
+				break;
+
+			case eSetValueWithOverwrite:
+				pxTCB->ulNotifiedValue = ulValue;
+				break;
+
+			case eSetValueWithoutOverwrite:
+				if( ucOriginalState != taskNOTIFICATION_RECEIVED )
+				{
+					pxTCB->ulNotifiedValue = ulValue;
+				}
+				else
+				{
+					xReturn = pdFAIL;
+				}
+				break;
+
+			case eNoAction:
+			default:
+				break;
+		}
+
+		pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+
+		if( ucOriginalState == taskWAITING_NOTIFICATION )
+		{
+			/* The task is blocked in the delayed or suspended list only. */
+			configASSERT( pxTCB->xEventListItem.pvContainer == NULL );
+
+			if( uxSchedulerSuspended == ( unsigned portBASE_TYPE ) pdFALSE )
+			{
+				vListRemove( &( pxTCB->xGenericListItem ) );
+				prvAddTaskToReadyQueue( pxTCB );
+			}
+			else
+			{
+				/* The ready lists cannot be accessed until the scheduler is
+				resumed, which moves the task to its ready list. */
+				vListInsertEnd( ( xList * ) &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+			}
+
+			if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				*pxYieldRequired = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	portBASE_TYPE xTaskNotify( xTaskHandle pxTaskToNotify, unsigned long ulValue, eNotifyAction eAction )
+	{
+	portBASE_TYPE xReturn, xYieldRequired = pdFALSE;
+
+		configASSERT( pxTaskToNotify );
+
+		taskENTER_CRITICAL();
+		{
+			xReturn = prvNotify( ( tskTCB * ) pxTaskToNotify, ulValue, eAction, &xYieldRequired );
+			if( xYieldRequired != pdFALSE )
+			{
+				portYIELD_WITHIN_API();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	portBASE_TYPE xTaskNotifyFromISR( xTaskHandle pxTaskToNotify, unsigned long ulValue, eNotifyAction eAction, portBASE_TYPE *pxHigherPriorityTaskWoken )
+	{
+	portBASE_TYPE xReturn, xYieldRequired = pdFALSE;
+	unsigned portBASE_TYPE uxSavedInterruptStatus;
+
+		configASSERT( pxTaskToNotify );
+
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			xReturn = prvNotify( ( tskTCB * ) pxTaskToNotify, ulValue, eAction, &xYieldRequired );
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+		if( ( xYieldRequired != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+		{
+			*pxHigherPriorityTaskWoken = pdTRUE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTaskNotifyGiveFromISR( xTaskHandle pxTaskToNotify, portBASE_TYPE *pxHigherPriorityTaskWoken )
+	{
+		( void ) xTaskNotifyFromISR( pxTaskToNotify, 0, eIncrement, pxHigherPriorityTaskWoken );
+	}
+	/*-----------------------------------------------------------*/
+
+	portBASE_TYPE xTaskNotifyWait( unsigned long ulBitsToClearOnEntry, unsigned long ulBitsToClearOnExit, unsigned long *pulNotificationValue, portTickType xTicksToWait )
+	{
+	portBASE_TYPE xReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if a notification is not already pending. */
+			if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+
+				if( xTicksToWait > ( portTickType ) 0 )
+				{
+					prvBlockCurrentTaskForNotification( xTicksToWait );
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		/* The task runs again here after it was notified or timed out. */
+		taskENTER_CRITICAL();
+		{
+			if( pulNotificationValue != NULL )
+			{
+				*pulNotificationValue = pxCurrentTCB->ulNotifiedValue;
+			}
+
+			if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+			{
+				xReturn = pdFALSE;
+			}
+			else
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnExit;
+				xReturn = pdTRUE;
+			}
+
+			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	unsigned long ulTaskNotifyTake( portBASE_TYPE xClearCountOnExit, portTickType xTicksToWait )
+	{
+	unsigned long ulReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if the count is zero. */
+			if( pxCurrentTCB->ulNotifiedValue == 0UL )
+			{
+				if( xTicksToWait > ( portTickType ) 0 )
+				{
+					prvBlockCurrentTaskForNotification( xTicksToWait );
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		/* The task runs again here after it was notified or timed out. */
+		taskENTER_CRITICAL();
+		{
+			ulReturn = pxCurrentTCB->ulNotifiedValue;
+
+			if( ulReturn != 0UL )
+			{
+				if( xClearCountOnExit != pdFALSE )
+				{
+					pxCurrentTCB->ulNotifiedValue = 0UL;
+				}
+				else
+				{
+					pxCurrentTCB->ulNotifiedValue = ulReturn - 1UL;
+				}
+			}
+
+			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif /* configUSE_TASK_NOTIFICATIONS */
+/*-----------------------------------------------------------*/
+
 /*
  * -----------------------------------------------------------
  * The Idle task.
@@ -2044,8 +2324,102 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 			vApplicationIdleHook();
 		}
 		#endif
+
+		#if ( configUSE_TICKLESS_IDLE == 1 )
+		{
+			portTickType xExpectedIdleTime;
+
+			/* Stop the tick interrupt and sleep until the next task is
+			expected to unblock, unless it is too soon to be worth it.  The
+			expected idle time is checked again with the scheduler suspended
+			as a task may have unblocked in the meantime. */
+			xExpectedIdleTime = prvGetExpectedIdleTime();
+			if( xExpectedIdleTime >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP )
+			{
+				vTaskSuspendAll();
+				{
+					xExpectedIdleTime = prvGetExpectedIdleTime();
+					if( xExpectedIdleTime >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP )
+					{
+						portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime );
+					}
+				}
+				xTaskResumeAll();
+			}
+		}
+		#endif
 	}
 } /*lint !e715 pvParameters is not accessed but all task functions require the same prototype. */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	static portTickType prvGetExpectedIdleTime( void )
+	{
+	portTickType xReturn;
+
+		if( pxCurrentTCB->uxPriority > tskIDLE_PRIORITY )
+		{
+			xReturn = 0;
+		}
+		else if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( unsigned portBASE_TYPE ) 1 )
+		{
+			/* Another task at the idle priority is ready to run. */
+			xReturn = 0;
+		}
+		else
+		{
+			xReturn = xNextTaskUnblockTime - xTickCount;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTaskStepTick( portTickType xTicksToJump )
+	{
+	portTickType xTicksBeforeUnblock = 0;
+
+		/* The tick count is jumped up to one tick before the next task is due
+		to unblock.  The remaining ticks are processed as missed ticks when
+		the scheduler is resumed, so the delayed tasks are unblocked (and the
+		delayed lists are swapped if the tick count overflows) as if the tick
+		interrupt had been running. */
+		configASSERT( uxSchedulerSuspended );
+		if( xNextTaskUnblockTime > xTickCount )
+		{
+			xTicksBeforeUnblock = xNextTaskUnblockTime - xTickCount - ( portTickType ) 1;
+		}
+
+		if( xTicksToJump > xTicksBeforeUnblock )
+		{
+			uxMissedTicks += ( unsigned portBASE_TYPE ) ( xTicksToJump - xTicksBeforeUnblock );
+			xTicksToJump = xTicksBeforeUnblock;
+		}
+
+		xTickCount += xTicksToJump;
+	}
+	/*-----------------------------------------------------------*/
+
+	portBASE_TYPE xTaskConfirmSleepModeStatus( void )
+	{
+	portBASE_TYPE xReturn = pdTRUE;
+
+		/* A task readied while the scheduler was suspended, or a context switch
+		that was held pending, means the idle task should not sleep. */
+		if( listCURRENT_LIST_LENGTH( &xPendingReadyList ) != 0 )
+		{
+			xReturn = pdFALSE;
+		}
+		else if( ( xMissedYield != pdFALSE ) || ( uxMissedTicks != 0 ) )
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
 
 
 
@@ -2113,6 +2487,13 @@ static void prvInitialiseTCBVariables( tskTCB *pxTCB, const signed char * const
 	}
 	#endif
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+	{
+		pxTCB->ulNotifiedValue = 0UL;
+		pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+	}
+	#endif
+
 	#if ( portUSING_MPU_WRAPPERS == 1 )
 	{
 		vPortStoreTaskMPUSettings( &( pxTCB->xMPUSettings ), xRegions, pxTCB->pxStack, usStackDepth );
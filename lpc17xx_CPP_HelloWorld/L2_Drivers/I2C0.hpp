@@ -0,0 +1,42 @@
+/**
+ * @file  I2C0.hpp
+ * @brief I2C0 Interrupt driven IO driver
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef I2C0_HPP_
+#define I2C0_HPP_
+
+
+
+#include "singletonTemplate.hpp"
+#include "i2c_base.hpp"
+
+
+
+/**
+ * I2C0 Singleton Driver
+ * This is a thin wrapper around I2C_Base class and gives the base address of the
+ * I2C0 memory map.  I2C0 uses the dedicated open-drain pins P0.27 (SDA0) and
+ * P0.28 (SCL0), which are only available on the 100-pin LPC176x packages.
+ *
+ * @ingroup Drivers
+ */
+class I2C0 : public I2C_Base, public SingletonTemplate<I2C0>
+{
+    public:
+        /// Initializes I2C0 at the given @param speedInKhz
+        bool init(unsigned int speedInKhz);
+
+    protected:
+        /// Clears a stuck I2C0 bus by toggling SCL (P0.28) until the slave releases SDA (P0.27)
+        void clearBus();
+
+    private:
+        I2C0(); ///< Private constructor for this singleton class
+        friend class SingletonTemplate<I2C0>;  ///< Friend class used for Singleton Template
+};
+
+
+
+#endif /* I2C0_HPP_ */
@@ -0,0 +1,60 @@
+/**
+ * @file  I2C1.hpp
+ * @brief I2C1 Interrupt driven IO driver
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef I2C1_HPP_
+#define I2C1_HPP_
+
+
+
+#include "singletonTemplate.hpp"
+#include "i2c_base.hpp"
+
+
+
+/// The pins that can be used by I2C1
+typedef enum {
+    I2C1Pins_P0_0_P0_1,     ///< SDA1 at P0.0,  SCL1 at P0.1
+    I2C1Pins_P0_19_P0_20    ///< SDA1 at P0.19, SCL1 at P0.20
+} I2C1PinsType;
+
+
+
+/**
+ * I2C1 Singleton Driver
+ * This is a thin wrapper around I2C_Base class and gives the base address of the
+ * I2C1 memory map.  I2C1 can use one of two pairs of pins, which are configured
+ * as open-drain since they are not dedicated I2C pins, so external pull-up
+ * resistors are needed on SDA and SCL.
+ *
+ * @ingroup Drivers
+ */
+class I2C1 : public I2C_Base, public SingletonTemplate<I2C1>
+{
+    public:
+        /**
+         * Initializes I2C1
+         * @param speedInKhz    The speed of the I2C bus
+         * @param pins          The pins to use for I2C1
+         */
+        bool init(unsigned int speedInKhz, I2C1PinsType pins=I2C1Pins_P0_0_P0_1);
+
+    protected:
+        /// Clears a stuck I2C1 bus by toggling SCL until the slave releases SDA
+        void clearBus();
+
+    private:
+        I2C1(); ///< Private constructor for this singleton class
+        friend class SingletonTemplate<I2C1>;  ///< Friend class used for Singleton Template
+
+        /// Switches the I2C1 pins to I2C if @param useI2C is true, otherwise to GPIO
+        void selectPins(bool useI2C);
+
+        I2C1PinsType mPins; ///< The pins used by I2C1
+};
+
+
+
+#endif /* I2C1_HPP_ */
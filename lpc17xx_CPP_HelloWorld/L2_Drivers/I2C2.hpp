@@ -25,6 +25,10 @@ class I2C2 : public I2C_Base, public SingletonTemplate<I2C2>
         /// Initializes I2C2 at the given @param speedInKhz
         bool init(unsigned int speedInKhz);
 
+    protected:
+        /// Clears a stuck I2C2 bus by toggling SCL (P0.11) until the slave releases SDA (P0.10)
+        void clearBus();
+
     private:
         I2C2(); ///< Private constructor for this singleton class
         friend class SingletonTemplate<I2C2>;  ///< Friend class used for Singleton Template
@@ -13,12 +13,122 @@ extern "C" {
 #include "sysConfig.h"
 
 
+
+#define ADC0_BURST_SWEEPS       64      ///< Number of sweeps (samples per channel) kept in the burst ring
+#define ADC0_BURST_DEFAULT_HZ   1000    ///< Default sample rate of each channel in burst mode
+
+
+
+/**
+ * Starts continuous sampling of the given channels using ADC burst mode.  At the end of
+ * each sweep of the channels, the GP-DMA copies the ADC data registers into a ring of
+ * ADC0_BURST_SWEEPS sweeps.  The DMA links the sweeps in a loop, so no interrupt
+ * occurs and sampling costs no CPU time.
+ *
+ * @param channelMask   Bit-mask of the channels to sample, such as (1 << 2) for AD0.2
+ * @param sampleRateHz  The sample rate of each channel.  The rate is limited by the ADC
+ *                      clock, and the actual rate is the closest rate that can be attained.
+ * @returns non-zero if successful, or zero if no DMA channel or memory is available
+ *
+ * @note Calling this again restarts sampling with the new channels, and the history is lost.
+ * @note The PINs used by ADC need to be selected using PINSEL externally
+ */
+int adc0_StartBurst(unsigned char channelMask, unsigned int sampleRateHz);
+
+/// Stops the burst mode sampling started by adc0_StartBurst()
+void adc0_StopBurst(void);
+
+/// @returns the bit-mask of the channels being sampled by burst mode, or 0 if stopped
+unsigned char adc0_GetBurstChannels(void);
+
+/**
+ * Gets the latest burst mode sample of a channel without waiting or locking.
+ * @returns 12-bit ADC value, or 0 if the channel has not been sampled yet
+ */
+unsigned short adc0_GetLatest(unsigned char channelNum);
+
+/**
+ * Copies the recent burst mode samples of a channel, oldest sample first.
+ * @param channelNum    The channel number between 0 - 7
+ * @param pSamples      The memory to copy the 12-bit samples to
+ * @param count         The number of samples wanted (up to ADC0_BURST_SWEEPS - 1)
+ * @returns The number of samples copied, which is less than count if fewer samples exist
+ *
+ * @note The samples are read while the DMA continues to write newer sweeps, so the oldest
+ *       sample may be overwritten if the caller is preempted for nearly the whole ring.
+ */
+unsigned int adc0_GetHistory(unsigned char channelNum, unsigned short* pSamples, unsigned int count);
+
+
+
+#define ADC0_MAX_OVERSAMPLE     256     ///< Maximum conversions averaged into one reading (power of 2)
+#define ADC0_MAX_FILTER_WINDOW  16      ///< Maximum window of the moving average filter
+
+/// The filter applied to the decimated readings of a channel in triggered mode
+typedef enum {
+    adc0_FilterNone,            ///< No filter: readings are the decimated conversions
+    adc0_FilterMovingAverage,   ///< Average of the last N decimated readings
+    adc0_FilterIir              ///< First order IIR: y += (x - y) / 2^N
+} adc0_FilterType;
+
+/**
+ * Starts conversions triggered by Timer0 match 1, so the conversions are started by
+ * the hardware at a precise rate without scheduling jitter.  The ADC interrupt
+ * converts the channels in turn, and adds up @param oversample conversions of a
+ * channel into one reading (decimation), which is then filtered using the filter
+ * set by adc0_SetFilter().
+ *
+ * @param channelMask   Bit-mask of the channels to sample, such as (1 << 2) for AD0.2
+ * @param readingRateHz The rate of the filtered readings of each channel
+ * @param oversample    The number of conversions per reading: 1, 2, 4 ... ADC0_MAX_OVERSAMPLE
+ * @returns non-zero if successful, or zero if the conversion rate exceeds the rate of
+ *          Timer0 (1 / TIMER0_US_PER_TICK) or the parameters are invalid
+ *
+ * @note The conversion rate is readingRateHz * oversample * (number of channels), and the
+ *       Timer0 resolution of TIMER0_US_PER_TICK quantizes the period between conversions.
+ * @note This stops burst mode, and adc0_StartBurst() stops this mode.
+ */
+int adc0_StartTriggered(unsigned char channelMask, unsigned int readingRateHz, unsigned int oversample);
+
+/// Stops the conversions started by adc0_StartTriggered()
+void adc0_StopTriggered(void);
+
+/// @returns the bit-mask of the channels converted by triggered mode, or 0 if stopped
+unsigned char adc0_GetTriggeredChannels(void);
+
+/**
+ * Sets the filter of a channel used in triggered mode.  The filter state is reset.
+ * @param channelNum    The channel number between 0 - 7
+ * @param filter        The type of the filter
+ * @param param         Moving average: window (1 - ADC0_MAX_FILTER_WINDOW),
+ *                      IIR: N of the 1/2^N coefficient (0 - 8)
+ */
+void adc0_SetFilter(unsigned char channelNum, adc0_FilterType filter, unsigned int param);
+
+/**
+ * Gets the latest filtered reading of a channel in triggered mode.
+ * The reading is scaled to 16-bits, so it keeps the extra resolution gained by
+ * oversampling and filtering.  Shift right by 4 to get a 12-bit value.
+ * @returns 16-bit reading, or 0 if no reading is available
+ */
+unsigned short adc0_GetFiltered(unsigned char channelNum);
+
+/// @returns the number of readings produced for a channel, which can be used to detect a new reading
+unsigned int adc0_GetReadingCount(unsigned char channelNum);
+
+
+
 /**
  * Initializes the ADC Peripheral
  * @note The PIN that will be used by ADC needs to be selected using PINSEL externally
+ * @note Nothing is done if burst or triggered mode is running, so it is not interrupted.
  */
 inline void adc0_initialize()
 {
+    if ((LPC_ADC->ADCR & (1 << 16)) || 0 != adc0_GetTriggeredChannels()) {
+        return;
+    }
+
     // Clear PDN bit before powering up ADC0
     LPC_SC->PCONP |= (1 << 12);     // Power up ADC
     LPC_ADC->ADCR = (1 << 21);      // Enable ADC
@@ -38,6 +148,8 @@ inline void adc0_initialize()
 
 /**
  * Gets an ADC reading from a channel number between 0 - 7
+ * If burst or triggered mode is running, the latest sample or filtered reading is
+ * returned without waiting, and 0 is returned for a channel that is not sampled.
  * @returns 12-bit ADC value read from the ADC.
  */
 inline unsigned short adc0_getReading(unsigned char channelNum)
@@ -45,6 +157,12 @@ inline unsigned short adc0_getReading(unsigned char channelNum)
     if(channelNum >= 8) {
         return 0;
     }
+    if(LPC_ADC->ADCR & (1 << 16)) {
+        return adc0_GetLatest(channelNum);
+    }
+    if(0 != adc0_GetTriggeredChannels()) {
+        return (adc0_GetFiltered(channelNum) >> 4);
+    }
 
     // Clear previously selected channel
     LPC_ADC->ADCR &= ~((0xFF) | (0x7 << 24));
@@ -0,0 +1,138 @@
+/**
+ * @file    gpdma.h
+ * @ingroup Drivers
+ * @brief   This file provides a small driver for the General Purpose DMA controller.
+ *          Drivers can acquire a DMA channel, start a transfer on it, and get a
+ *          callback from the DMA interrupt when the transfer completes.
+ *
+ * @warning The GP-DMA cannot access the local SRAM (0x10000000) where all of the
+ *          program variables, heap and stacks reside.  Memory used for DMA transfers
+ *          must be obtained from gpdma_Malloc() or declared with GPDMA_MEMORY.
+ */
+#ifndef GPDMA_H_
+#define GPDMA_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "LPC17xx.h"
+
+
+
+/// Places a variable in the AHB SRAM which is accessible by the GP-DMA
+#define GPDMA_MEMORY                __attribute__ ((section(".bss.$RamAHB32")))
+#define GPDMA_NUM_CHANNELS          8       ///< Number of GP-DMA channels
+#define GPDMA_MAX_TRANSFER_SIZE     4095    ///< Maximum transfer size of a single DMA transfer
+#define GPDMA_MEMORY_POOL_BYTES     (8 * 1024)  ///< Size of memory pool for gpdma_Malloc()
+
+/**
+ * @{ \name Bits of the DMA Channel Control register
+ */
+#define GPDMA_CTRL_SIZE(n)          ((n) & 0xFFF)   ///< Transfer size
+#define GPDMA_CTRL_SRC_BURST(b)     ((b) << 12)     ///< Source burst (0=1, 1=4, 2=8, 3=16 ...)
+#define GPDMA_CTRL_DST_BURST(b)     ((b) << 15)     ///< Destination burst (0=1, 1=4, 2=8, 3=16 ...)
+#define GPDMA_CTRL_SRC_WIDTH(w)     ((w) << 18)     ///< Source width (0=byte, 1=half-word, 2=word)
+#define GPDMA_CTRL_DST_WIDTH(w)     ((w) << 21)     ///< Destination width (0=byte, 1=half-word, 2=word)
+#define GPDMA_CTRL_SRC_INC          (1 << 26)       ///< Increment source address after each transfer
+#define GPDMA_CTRL_DST_INC          (1 << 27)       ///< Increment destination address after each transfer
+#define GPDMA_CTRL_TC_INTR          (1U << 31)      ///< Generate terminal count interrupt
+/** @} */
+
+/**
+ * @{ \name Bits of the DMA Channel Config register
+ */
+#define GPDMA_CFG_SRC_PERIPH(p)     ((p) << 1)      ///< Source peripheral (request number)
+#define GPDMA_CFG_DST_PERIPH(p)     ((p) << 6)      ///< Destination peripheral (request number)
+#define GPDMA_CFG_M2M               (0 << 11)       ///< Memory to memory transfer
+#define GPDMA_CFG_M2P               (1 << 11)       ///< Memory to peripheral transfer
+#define GPDMA_CFG_P2M               (2 << 11)       ///< Peripheral to memory transfer
+/** @} */
+
+/// DMA request numbers of the peripherals
+typedef enum {
+    gpdma_ssp0Tx  = 0,  gpdma_ssp0Rx  = 1,
+    gpdma_ssp1Tx  = 2,  gpdma_ssp1Rx  = 3,
+    gpdma_adc     = 4,
+    gpdma_i2s0    = 5,  gpdma_i2s1    = 6,
+    gpdma_dac     = 7,
+    gpdma_uart0Tx = 8,  gpdma_uart0Rx = 9,
+    gpdma_uart1Tx = 10, gpdma_uart1Rx = 11,
+    gpdma_uart2Tx = 12, gpdma_uart2Rx = 13,
+    gpdma_uart3Tx = 14, gpdma_uart3Rx = 15
+} gpdma_Peripheral;
+
+/**
+ * DMA Linked List Item that the DMA loads after completing a transfer.
+ * This must reside in memory accessible by the DMA.
+ */
+typedef struct gpdma_Lli {
+    unsigned int src;               ///< Source address
+    unsigned int dst;               ///< Destination address
+    const struct gpdma_Lli* pNext;  ///< Next LLI, or NULL if none
+    unsigned int control;           ///< Channel control word
+} gpdma_Lli;
+
+/**
+ * Callback from the DMA interrupt when a transfer completes
+ * @param pArg      The argument that was given to gpdma_AcquireChannel()
+ * @param error     Non-zero if the transfer completed due to an error
+ */
+typedef void (*gpdma_CallbackType)(void* pArg, int error);
+
+
+
+/**
+ * Enables power to the DMA controller and enables the DMA interrupt.
+ * This can be called multiple times, but only the first call has effect.
+ */
+void gpdma_Init(void);
+
+/**
+ * Acquires a free DMA channel
+ * @param highPriority  If non-zero, a channel with high priority is given (lower channel number)
+ * @param callback      The function to call when a transfer completes on this channel
+ * @param pArg          The argument to give to the callback function
+ * @returns The channel number, or -1 if no channel is free
+ */
+int gpdma_AcquireChannel(int highPriority, gpdma_CallbackType callback, void* pArg);
+
+/**
+ * Starts a transfer on the given DMA channel.
+ * @param channel   The channel obtained from gpdma_AcquireChannel()
+ * @param src       The source address
+ * @param dst       The destination address
+ * @param pNextLli  The linked list item to load after this transfer, or NULL
+ * @param control   The control word, built using GPDMA_CTRL_ macros
+ * @param config    The config word, built using GPDMA_CFG_ macros
+ * @post  Error and terminal count interrupts are enabled for the channel
+ */
+void gpdma_Start(int channel, unsigned int src, unsigned int dst,
+                 const gpdma_Lli* pNextLli, unsigned int control, unsigned int config);
+
+/// Stops (disables) the given DMA channel
+void gpdma_Stop(int channel);
+
+/// @returns non-zero if the given channel is still performing a transfer
+int gpdma_IsBusy(int channel);
+
+/// @returns the channel registers of the given DMA channel
+static inline LPC_GPDMACH_TypeDef* gpdma_GetChannel(int channel)
+{
+    return (LPC_GPDMACH_TypeDef*) (LPC_GPDMACH0_BASE + (channel * 0x20));
+}
+
+/**
+ * Allocates memory accessible by the DMA.  This memory cannot be freed.
+ * @param bytes     The number of bytes to allocate (will be rounded up to 4 bytes)
+ * @returns The pointer to the memory, or NULL if no more memory is available
+ */
+void* gpdma_Malloc(unsigned int bytes);
+
+/// @returns non-zero if the memory pointed by @param pMem can be accessed by the DMA
+int gpdma_IsAccessible(const void* pMem);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* GPDMA_H_ */
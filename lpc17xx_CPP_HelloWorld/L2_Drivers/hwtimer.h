@@ -0,0 +1,98 @@
+/**
+ * @file    hwtimer.h
+ * @ingroup Drivers
+ * @brief   Hardware timer service that runs any number of one-shot and periodic
+ *          callbacks at microsecond resolution.
+ *
+ * Timer2 counts microseconds and never stops.  The timers are kept in a list sorted by
+ * their deadline, and the match register is only programmed for the timer at the head
+ * of the list, so there is a single interrupt for each expiry regardless of how many
+ * timers are running.  The interrupt only looks at the expired timers at the head of
+ * the list, so its overhead is bounded by the timers that expire together.
+ *
+ * The callbacks run from the Timer2 ISR, so they should be short and may only use the
+ * FreeRTOS "FromISR" API.  The timer structures are owned by the caller (no memory is
+ * allocated), and must remain valid while the timer is running.
+ *
+ * Example:
+ * @code
+ *      static hwtimer_Timer gBlink;
+ *      void blink(void* pArg) { LPC_GPIO1->FIOPIN ^= (1 << 0); }
+ *      hwtimer_StartPeriodic(&gBlink, 250, blink, 0);   // Every 250us
+ * @endcode
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef HWTIMER_H_
+#define HWTIMER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define HWTIMER_MIN_PERIOD_US   10      ///< Minimum period of a periodic timer
+
+/// The callback function of a timer, @param pArg is the argument given when the timer was started
+typedef void (*hwtimer_Callback)(void* pArg);
+
+/**
+ * A timer, which must be zero initialized (such as a static variable) before it is started.
+ * The members are private to the timer service.
+ */
+typedef struct hwtimer_Timer {
+    unsigned int deadline;          ///< The Timer2 count when the timer expires
+    unsigned int periodUs;          ///< The period of a periodic timer, or zero for a one-shot timer
+    hwtimer_Callback callback;      ///< The function called when the timer expires
+    void* pArg;                     ///< The argument of the callback
+    struct hwtimer_Timer* pNext;    ///< The next timer in the list of running timers
+    char running;                   ///< Non-zero while the timer is in the list of running timers
+} hwtimer_Timer;
+
+
+
+/**
+ * Initializes Timer2 to count microseconds.
+ * This is called by the first timer that is started if it hasn't been called already.
+ */
+void hwtimer_Init(void);
+
+/// @returns the microsecond count of Timer2 (wraps after 71 minutes)
+unsigned int hwtimer_GetMicros(void);
+
+/**
+ * Starts (or re-starts) a one-shot timer
+ * @param pTimer    The timer to start
+ * @param delayUs   The microseconds until the timer expires
+ * @param callback  The function to call when the timer expires
+ * @param pArg      The argument to pass to the callback
+ */
+void hwtimer_StartOneShot(hwtimer_Timer* pTimer, unsigned int delayUs,
+                          hwtimer_Callback callback, void* pArg);
+
+/**
+ * Starts (or re-starts) a periodic timer
+ * @param pTimer    The timer to start
+ * @param periodUs  The period in microseconds (HWTIMER_MIN_PERIOD_US minimum)
+ * @param callback  The function to call at each period
+ * @param pArg      The argument to pass to the callback
+ * @note If an expiry is missed, the timer skips to the next period instead of catching up.
+ */
+void hwtimer_StartPeriodic(hwtimer_Timer* pTimer, unsigned int periodUs,
+                           hwtimer_Callback callback, void* pArg);
+
+/**
+ * Stops a timer if it is running.
+ * This can be called from any callback, including the callback of the same timer.
+ */
+void hwtimer_Stop(hwtimer_Timer* pTimer);
+
+/// @returns the maximum microseconds a callback was called after its deadline
+unsigned int hwtimer_GetMaxLateUs(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HWTIMER_H_ */
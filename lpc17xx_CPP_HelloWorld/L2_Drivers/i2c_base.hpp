@@ -7,26 +7,109 @@
 
 #include "LPC17xx.h"
 #include "FreeRTOS.h"
-#include "task.h"       // xTaskGetSchedulerState()
+#include "task.h"       // xTaskGetSchedulerState(), task notifications
 #include "semphr.h"     // Semaphores used in I2C
 
 
 
 /**
- * For mutli-byte I2C transfers, this macro defines the maximum buffer size
- * to perform multi byte transfers.
+ * Define the default deadline of a transaction measured from the time it starts on the bus.
+ * If a transaction misses its deadline, it is stopped, and the I2C bus is recovered.
  */
-#define I2C_FRAME_MAX_DATABYTES  4
+#define I2C_TIMEOUT_MS      100
 
 /**
- * Define the maximum timeout for read operation (in case error occurs)
+ * @{ \name Transaction errors that are not I2C states
+ * The I2C states (I2STAT) are multiples of 8, except that bus error is 0, so bus error
+ * is reported as I2C_ERROR_BUS instead.
  */
-#define I2C_READ_TIMEOUT_MS      100
+#define I2C_ERROR_BUS       0x01    ///< Bus error (illegal START or STOP)
+#define I2C_ERROR_TIMEOUT   0xFF    ///< Transaction missed its deadline
+/** @} */
+
+
+
+/**
+ * Callback when an asynchronous I2C transaction completes.
+ * @param pArg      The argument given when the transaction was submitted
+ * @param error     0 if successful, or the I2C state that caused the error
+ * @warning This is called from the I2C interrupt, so only FreeRTOS FromISR() API can be used
+ */
+typedef void (*I2C_CallbackType)(void* pArg, char error);
+
+/**
+ * I2C transaction descriptor used to queue transactions to the I2C_Base.
+ * The memory of the transaction and its data must remain valid until it completes.
+ */
+typedef struct I2C_Transaction
+{
+    char slaveAddress;              ///< Slave Device Address
+    char firstRegister;             ///< 1st Register to Read or Write
+    bool isRead;                    ///< True for read, false for write transaction
+    char* pData;                    ///< The data to read or write
+    unsigned int length;            ///< The number of bytes to read or write
+
+    I2C_CallbackType callback;      ///< Optional callback upon completion
+    void* pCallbackArg;             ///< Argument given to the callback
+    xSemaphoreHandle doneSignal;    ///< Optional semaphore given upon completion
+    xTaskHandle notifyTask;         ///< Optional task notified upon completion (used by blocking transfers)
+    unsigned short timeoutMs;       ///< Deadline after the transaction starts, or 0 to use I2C_TIMEOUT_MS
+    unsigned int submitTime;        ///< Used by I2C_Base to measure latency of the transaction
+
+    volatile char error;            ///< Set upon completion: 0 if successful, or the I2C error state
+    volatile bool done;             ///< Set to true when the transaction completes
+    struct I2C_Transaction* pNext;  ///< Used by the I2C_Base transaction queue
+} I2C_Transaction;
+
+
+
+/**
+ * I2C Bus statistics to assess the error rate and worst-case latency of the I2C bus
+ */
+typedef struct
+{
+    unsigned int transactions;      ///< Number of completed transactions
+    unsigned int errors;            ///< Number of transactions that completed with an error
+    unsigned int nacks;             ///< Number of transactions not acknowledged by the slave
+    unsigned int timeouts;          ///< Number of transactions that missed their deadline
+    unsigned int arbitrationLost;   ///< Number of transactions that lost arbitration
+    unsigned int busErrors;         ///< Number of transactions with a bus error
+    unsigned int busRecoveries;     ///< Number of times the bus was recovered
+    unsigned int lastLatencyUs;     ///< Time from submitting to completing the last transaction
+    unsigned int maxLatencyUs;      ///< Worst-case time from submitting to completing a transaction
+    unsigned int maxBusTimeUs;      ///< Worst-case time a transaction used the bus
+    unsigned int slaveReads;        ///< Number of times another master read our slave window
+} I2C_Stats;
+
 
 
 /**
  * I2C Base class that can be used to write drivers for all I2C peripherals.
  *
+ * All transactions go through a queue.  When a transaction completes, the I2C
+ * interrupt starts the next queued transaction directly, so transactions queued
+ * by readAsync() or writeAsync() execute back to back without any context switch.
+ * The blocking functions such as readRegisters() queue a transaction and wait for it.
+ *
+ * Each transaction has a deadline.  If the active transaction misses its deadline,
+ * it completes with I2C_ERROR_TIMEOUT, and the bus is recovered by clocking out a
+ * stuck slave (if the derived class supports it) and resetting the I2C peripheral.
+ * The I2C peripheral is also reset upon arbitration loss or bus error.
+ *
+ * The I2C peripheral can also act as a slave at the same time by calling initSlave().
+ * As a slave, it exposes a window of registers that another master can read like
+ * a register-mapped I2C device: the master writes the first register, and then reads
+ * any number of bytes with auto-increment.  The window is double-buffered and serviced
+ * entirely in the ISR.  updateSlaveWindow() writes the back buffer, and then swaps it,
+ * while the ISR keeps using the same buffer until the master's read is over, so the
+ * master never reads a partially updated window.
+ *
+ * @code
+ *  I2C2::getInstance().initSlave(0xA0, sizeof(telemetry));
+ *  ...
+ *  I2C2::getInstance().updateSlaveWindow((char*)&telemetry, sizeof(telemetry));
+ * @endcode
+ *
  * @ingroup Drivers
  */
 class I2C_Base
@@ -59,6 +142,7 @@ class I2C_Base
          * Reads multiple bytes from an I2C device starting from the first register
          * It is assumed that like almost all I2C devices, the register address increments by 1
          * upon reading each byte.  This is usually how all I2C devices work.
+         * The data is read directly into pData, so there is no limit on the number of bytes.
          * @param deviceAddress     The device address to read data from
          * @param firstReg          The first register to read from
          * @param pData             The pointer to where to store the data
@@ -67,6 +151,80 @@ class I2C_Base
          */
         bool readRegisters(char deviceAddress, char firstReg, char* pData, unsigned int bytesToRead);
 
+        /**
+         * Writes multiple bytes to an I2C device starting from the first register
+         * The data is written directly from pData, and this function returns after
+         * the data has been written, so there is no limit on the number of bytes.
+         * @param deviceAddress     The device address to write data to
+         * @param firstReg          The first register to write to
+         * @param pData             The pointer to the data to write
+         * @param bytesToWrite      The number of bytes to write
+         * @returns true if the write was successful
+         */
+        bool writeRegisters(char deviceAddress, char firstReg, const char* pData, unsigned int bytesToWrite);
+
+        /**
+         * @{ \name Asynchronous Read and Write
+         * Queues a transaction and returns immediately.  Upon completion, the transaction's
+         * done flag is set, the callback is called and the doneSignal is given (if provided).
+         * @param t         The transaction memory, which must remain valid until it completes
+         * @param callback  Optional callback from the ISR upon completion
+         * @param pArg      The argument to give to the callback
+         * @param doneSignal Optional semaphore to give upon completion
+         * @see readRegisters() and writeRegisters() for the rest of the parameters
+         * @warning These are not to be used from an ISR
+         */
+        void readAsync(I2C_Transaction& t, char deviceAddress, char firstReg, char* pData, unsigned int bytesToRead,
+                       I2C_CallbackType callback=0, void* pArg=0, xSemaphoreHandle doneSignal=0);
+        void writeAsync(I2C_Transaction& t, char deviceAddress, char firstReg, const char* pData, unsigned int bytesToWrite,
+                        I2C_CallbackType callback=0, void* pArg=0, xSemaphoreHandle doneSignal=0);
+        /** @} */
+
+        /**
+         * Queues a transaction that has been filled out by the caller.
+         * @see readAsync()
+         */
+        void submit(I2C_Transaction& t);
+
+        /// Waits until all of the queued transactions have completed
+        void flush();
+
+        /**
+         * Checks if the active transaction missed its deadline, and if so, completes it with
+         * I2C_ERROR_TIMEOUT and recovers the bus.  Tasks waiting for a transaction call this
+         * automatically, but it should be called periodically if only asynchronous transactions
+         * are used without anyone waiting for them.
+         */
+        void checkDeadline();
+
+        /// @returns the statistics of this I2C bus
+        inline const I2C_Stats& getStats() const { return mStats; }
+
+        /// Resets the statistics of this I2C bus
+        void resetStats();
+
+        /**
+         * Enables the slave mode with a window of registers that other masters can read.
+         * This can only be called once, after the derived class has initialized the I2C.
+         * @param slaveAddress  Our slave address (8-bit address with R/W bit as zero)
+         * @param windowSize    The number of registers in the window
+         * @returns true if the memory for the window was allocated and slave mode is enabled
+         */
+        bool initSlave(char slaveAddress, unsigned int windowSize);
+
+        /**
+         * Updates the slave window that other masters read.  The data is written to the back
+         * buffer, and the buffers are swapped after that, so only one task should update the window.
+         * @param pData The data to write at the start of the window
+         * @param len   The length of the data, the rest of the window keeps its current data
+         * @returns true if updated, or false if the back buffer is still being read by a master
+         *          that started reading before the last update, in which case try again later.
+         */
+        bool updateSlaveWindow(const char* pData, unsigned int len);
+
+        /// @returns the size of the slave window, or 0 if slave mode is not enabled
+        inline unsigned int getSlaveWindowSize() const { return mSlaveWindowSize; }
+
         /**
          * This function can be used to check if an I2C device responds to its address, which
          * can therefore be used to discover all I2C hardware devices.
@@ -93,13 +251,39 @@ class I2C_Base
          */
         bool init(unsigned int pclk, unsigned int busRateInKhz);
 
+        /**
+         * The derived class can override this to free the bus if a slave is holding SDA low
+         * by switching the pins to GPIO and clocking SCL until SDA is released.
+         * This is called before the I2C peripheral is reset, from the I2C ISR or from a task
+         * inside a critical section, so it busy-waits for the short time it takes (about 100us).
+         */
+        virtual void clearBus() {}
+
+        /**
+         * Clocks SCL until a slave releases SDA, and then generates a STOP.  This can be used by
+         * the derived class's clearBus() after it switches the I2C pins to GPIO.
+         * SCL is clocked at 100Khz or slower, timed by the CPU cycle counter.
+         * @param pGpio     The GPIO port of the I2C pins
+         * @param sdaMask   The bit-mask of the SDA pin
+         * @param sclMask   The bit-mask of the SCL pin
+         */
+        static void clockOutBus(LPC_GPIO_TypeDef* pGpio, unsigned int sdaMask, unsigned int sclMask);
+
+        /// Virtual destructor of this base class
+        virtual ~I2C_Base() {}
+
 
 
     private:
         LPC_I2C_TypeDef* mpI2CRegs;    ///< Pointer to I2C memory map
         IRQn_Type        mIRQ;         ///< IRQ of this I2C
-        xSemaphoreHandle mI2CMutex;    ///< I2C Mutex used when FreeRTOS is running
-        xSemaphoreHandle mReadCompSig; ///< Signal that indicates read is complete
+        xSemaphoreHandle mI2CMutex;    ///< Mutex used by tasks waiting for the queue to become empty
+        xTaskHandle mIdleWaitingTask;  ///< The task notified when the transaction queue becomes empty
+
+        I2C_Transaction* volatile mpQueueHead;  ///< The active transaction, followed by the queued ones
+        I2C_Transaction* volatile mpQueueTail;  ///< The last queued transaction
+        unsigned int mActiveStartTime;  ///< Timer0 tick when the active transaction started
+        I2C_Stats mStats;               ///< Statistics of this I2C bus
 
         /**
          * The status of I2C is returned from the I2C function that handles state machine
@@ -129,9 +313,9 @@ class I2C_Base
 
             mI2cModeType mode;  ///< Tracks read vs. write mode
 
-            char rwBuffer[I2C_FRAME_MAX_DATABYTES]; ///< Buffer of the I2C Read or Write
-            short bytesToTransfer;                  ///< # of bytes to transfer.
-            short bytePointer;                      ///< Tracks the byte number being read or written.
+            char* pBuffer;                  ///< Caller's buffer of the I2C Read or Write
+            unsigned int bytesToTransfer;   ///< # of bytes to transfer.
+            unsigned int bytePointer;       ///< Tracks the byte number being read or written.
         }mI2CFrameType;
 
         /// The I2C Input Output frame that contains I2C transaction information
@@ -148,13 +332,67 @@ class I2C_Base
 
         /**
          * This is the entry point for an I2C transaction
-         * @param mode      Read or Write Mode
+         * @param t  The transaction to start
+         */
+        void i2cKickOffTransfer(const I2C_Transaction& t);
+
+        /**
+         * Performs an I2C transaction and waits for it to complete
+         * @param isRead    True for read, false for write
          * @param devAddr   The address of the I2C Device
          * @param regStart  The register address of I2C device to read or write
          * @param pBytes    The pointer to one or more data bytes to read or write
          * @param len       The length of the I2C transaction
+         * @returns 0 if successful, or the I2C state that caused the error
+         */
+        char transfer(bool isRead, char devAddr, char regStart, char* pBytes, unsigned int len);
+
+        /**
+         * Completes the active transaction at the head of the queue, and starts the next one.
+         * @param pHigherPriorityTaskWoken  Set to true if a task was woken by completing the transaction
+         */
+        void completeTransaction(long* pHigherPriorityTaskWoken);
+
+        /**
+         * Recovers the bus after an error
+         * @param clearBusLines  If true, clearBus() is called to free a stuck slave
+         */
+        void recoverBus(bool clearBusLines);
+
+        /// Resets the I2C peripheral which releases the bus and clears the state machine
+        void resetPeripheral();
+
+        /// Updates the statistics upon completing transaction @param t with @param error
+        void updateStats(const I2C_Transaction& t, char error);
+
+        /**
+         * Handles the slave states of the I2C state machine
+         * @param i2cState  The I2C state (I2STAT)
+         */
+        void slaveStateMachine(unsigned int i2cState);
+
+        char* mpSlaveBuff[2];               ///< The double-buffered slave window
+        const char* volatile mpSlaveReading;///< The buffer being read by a master, or NULL
+        volatile unsigned char mSlaveActive;///< The index of the latest buffer of the slave window
+        unsigned int mSlaveWindowSize;      ///< The size of the slave window
+        unsigned int mSlaveOffset;          ///< The register of the slave window to read next
+        bool mSlaveGotRegister;             ///< True after the master has written the first register
+
+        /**
+         * Runs the I2C state machine by polling until the given transaction is done, or
+         * the queue is empty if @param pTrans is NULL.  This is used when FreeRTOS is not running.
+         * @pre I2C interrupt must be disabled
+         */
+        void pollUntilDone(I2C_Transaction* pTrans);
+
+        /**
+         * @{ \name Protects the transaction queue from the I2C interrupt and other tasks.
+         * Critical section is not used before FreeRTOS starts because it would stay
+         * in effect until the scheduler starts, so interrupts are disabled instead.
          */
-        void i2cKickOffTransfer(mI2cModeType mode, char devAddr, char regStart, char* pBytes, int len);
+        void lockQueue();
+        void unlockQueue();
+        /** @} */
 
 };
 
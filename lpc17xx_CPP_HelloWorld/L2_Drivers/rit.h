@@ -0,0 +1,51 @@
+/**
+ * @file    rit.h
+ * @ingroup Drivers
+ * @brief   Repetitive Interrupt Timer (RIT) shared by several periodic callbacks
+ *
+ * Each callback has its own period in milliseconds.  The RIT interrupts at the
+ * greatest common divisor of all the periods, so callbacks at 10ms and 25ms for
+ * example only need an interrupt every 5ms.  The callbacks run from the RIT ISR.
+ *
+ * Use hwtimer.h instead for callbacks that need microsecond resolution.
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef RIT_H_
+#define RIT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define RIT_MAX_CALLBACKS   4   ///< Maximum number of callbacks that can be added
+
+/// The callback function called periodically from the RIT ISR
+typedef void (*rit_Callback)(void);
+
+
+
+/**
+ * Adds a periodic callback, and starts the RIT if it is not running.
+ * @param callback  The function to call
+ * @param periodMs  The period in milliseconds
+ * @returns non-zero if the callback was added, or zero if RIT_MAX_CALLBACKS were already added
+ */
+int rit_AddCallback(rit_Callback callback, unsigned int periodMs);
+
+/**
+ * Removes a callback added by rit_AddCallback()
+ * @returns non-zero if the callback was found and removed
+ */
+int rit_RemoveCallback(rit_Callback callback);
+
+/// @returns the period of the RIT interrupt in milliseconds, or zero if the RIT is stopped
+unsigned int rit_GetTickMs(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* RIT_H_ */
@@ -8,6 +8,16 @@
 extern "C" {
 #endif
 #include "LPC17xx.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "ssp.h"        // Functions shared with ssp0
+
+
+
+#define SPI1_USE_DMA            1       ///< Use the GP-DMA for block transfers
+#define SPI1_DMA_MIN_BYTES      16      ///< Transfers shorter than this are not worth the DMA setup
+#define SPI1_DMA_BOUNCE_BYTES   512     ///< Size of the DMA accessible buffer used for local SRAM data
+#define SPI1_DMA_TIMEOUT_MS     1000    ///< Maximum time to wait for a DMA transfer to complete
 
 
 
@@ -24,6 +34,62 @@ void spi1_SetMaxClockMhz(unsigned int maxClockMhz);
  */
 void spi1_Init();
 
+
+
+/**
+ * The profile of a device on the SPI bus.  The SSP register values are computed
+ * once by spi1_InitDevice() so acquiring the bus only needs to compare and copy them.
+ */
+typedef ssp_Device spi1_Device;
+
+/**
+ * Sets the mutex used by spi1_Acquire() to give one device at a time the SPI bus.
+ * The mutex is only used once FreeRTOS is running.
+ */
+void spi1_SetBusMutex(xSemaphoreHandle mutex);
+
+/**
+ * Initializes a device profile, and sets its chip-select as an output (de-selected).
+ * @param pDev          The profile to initialize
+ * @param maxClockKhz   The maximum SCK of this device in Kilohertz
+ * @param mode          The SPI mode 0-3 of this device
+ * @param pCsPort       The GPIO port of the chip-select, such as LPC_GPIO0
+ * @param csMask        The bit-mask of the chip-select, such as (1 << 16)
+ * @note The speed may be set lower to maxClockKhz if it cannot be attained.
+ */
+void spi1_InitDevice(spi1_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                     LPC_GPIO_TypeDef* pCsPort, unsigned int csMask);
+
+/// @see ssp_ComputeDeviceProfile()
+void spi1_ComputeDeviceProfile(spi1_Device* pDev, unsigned int maxClockKhz);
+
+/**
+ * Changes the clock of a device profile, such as the SD Card switching to fast clock.
+ * If the device is using the bus, the new clock is applied right away.
+ */
+void spi1_SetDeviceClock(spi1_Device* pDev, unsigned int maxClockKhz);
+
+/**
+ * Acquires the SPI bus for a device, and configures the SSP with the device's profile
+ * if the profile differs from the one used by the previous owner of the bus.
+ * Every spi1_Acquire() must be followed by spi1_Release()
+ */
+void spi1_Acquire(const spi1_Device* pDev);
+
+/// Releases the SPI bus acquired by spi1_Acquire()
+void spi1_Release(void);
+
+/// @returns the number of times the SSP was re-configured for a different device profile
+unsigned int spi1_GetProfileSwitches(void);
+
+/// Selects the device by asserting its chip-select (the bus should be acquired)
+static inline void spi1_Select(const spi1_Device* pDev)   { pDev->pCsPort->FIOCLR = pDev->csMask; }
+
+/// De-selects the device by de-asserting its chip-select
+static inline void spi1_Deselect(const spi1_Device* pDev) { pDev->pCsPort->FIOSET = pDev->csMask; }
+
+
+
 /**
  * Exchanges a byte over SPI bus
  * @param out   The byte to send out
@@ -37,19 +103,53 @@ inline char spi1_ExchangeByte(char out)
 }
 
 /**
- * Sends a block of 256 bytes pointed by @param p256Bytes
+ * Transfers a block of data using the SSP FIFO.  Unlike exchanging byte by byte,
+ * this keeps the 8-entry FIFO full rather than waiting for each byte to finish.
+ * @param pTx   The data to send, or NULL to send 0xFF (receive only)
+ * @param pRx   The memory to store the received data, or NULL to discard it (send only)
+ * @param len   The number of bytes to transfer (any length)
+ */
+void spi1_Transfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len);
+
+/**
+ * Same as spi1_Transfer() except that SSP is switched to 16-bit frames during the transfer,
+ * which halves the number of FIFO accesses.  Each 16-bit value is sent MSB first.
+ * @param count The number of 16-bit values to transfer
+ */
+void spi1_Transfer16(const unsigned short* pTx, unsigned short* pRx, unsigned int count);
+
+/**
+ * Receives 256 bytes and saves it to @param p256Bytes
  * Unlike sending byte by byte, this function uses GP-DMA if enabled, or
  * using SPI FIFO to speed up the transfer.
  */
 void spi1_Receive256Bytes(unsigned char* p256Bytes);
 
 /**
- * Receives 256 bytes and saves it to @param p256Bytes
+ * Sends a block of 256 bytes pointed by @param p256Bytes
  * Unlike sending byte by byte, this function uses GP-DMA if enabled, or
  * using SPI FIFO to speed up the transfer.
  */
 void spi1_Send256Bytes(const unsigned char* p256Bytes);
 
+#if SPI1_USE_DMA
+/**
+ * Transfers a block of data using the GP-DMA.  The calling task sleeps until the DMA
+ * completes the transfer, so other tasks can run during the transfer.  If FreeRTOS is
+ * not running yet, the transfer completes by polling the DMA.
+ *
+ * @param pTx   The data to send, or NULL to send 0xFF (receive only)
+ * @param pRx   The memory to store the received data, or NULL to discard it (send only)
+ * @param len   The number of bytes to transfer (any length)
+ * @returns non-zero if successful, or zero if the DMA reported an error or timed out
+ *
+ * @note  Data in the local SRAM is copied through a DMA accessible bounce buffer, so
+ *        data obtained from gpdma_Malloc() or declared with GPDMA_MEMORY is faster.
+ * @note  The caller should hold the SPI mutex, same as all other spi1 functions.
+ */
+int spi1_DmaTransfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len);
+#endif
+
 
 
 #ifdef __cplusplus
@@ -0,0 +1,46 @@
+#include "I2C0.hpp"
+#include "LPC17xx.h"
+
+
+
+
+/**
+ * IRQ Handler needs to be enclosed in extern "C" because this is C++ file, and
+ * we don't want C++ to "mangle" this function name.
+ * This ISR Function need needs to be named precisely to override "WEAK" ISR
+ * handler defined at cr_startup_lpc175x.cpp
+ */
+extern "C"
+{
+    void I2C0_IRQHandler()
+    {
+        I2C0::getInstance().handleInterrupt();
+    }
+}
+
+
+
+bool I2C0::init(unsigned int speedInKhz)
+{
+    LPC_PINCON->PINSEL1 &= ~(0xF << 22);  // Clear
+    LPC_PINCON->PINSEL1 |=  (0x5 << 22);  // Enable I2C Pins: SDA0, SCL0
+
+    // Set I2C0 Peripheral Clock divider to 4
+    LPC_SC->PCLKSEL0 &= ~(3 << 14);
+    const unsigned int pclk = getCpuClock() / 4;
+
+    return I2C_Base::init(pclk, speedInKhz);
+}
+
+void I2C0::clearBus()
+{
+    // Switch the pins to GPIO while clocking out the bus, and then give them back to I2C
+    LPC_PINCON->PINSEL1 &= ~(0xF << 22);
+    clockOutBus(LPC_GPIO0, (1 << 27), (1 << 28));
+    LPC_PINCON->PINSEL1 |= (0x5 << 22);
+}
+
+I2C0::I2C0() : I2C_Base((LPC_I2C_TypeDef*) LPC_I2C0_BASE)
+{
+
+}
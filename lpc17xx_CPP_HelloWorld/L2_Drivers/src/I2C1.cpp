@@ -0,0 +1,78 @@
+#include "I2C1.hpp"
+#include "LPC17xx.h"
+
+
+
+
+/**
+ * IRQ Handler needs to be enclosed in extern "C" because this is C++ file, and
+ * we don't want C++ to "mangle" this function name.
+ * This ISR Function need needs to be named precisely to override "WEAK" ISR
+ * handler defined at cr_startup_lpc175x.cpp
+ */
+extern "C"
+{
+    void I2C1_IRQHandler()
+    {
+        I2C1::getInstance().handleInterrupt();
+    }
+}
+
+
+
+bool I2C1::init(unsigned int speedInKhz, I2C1PinsType pins)
+{
+    mPins = pins;
+
+    // Pins are not dedicated I2C pins, so make them open-drain without pull-up or pull-down
+    if(I2C1Pins_P0_0_P0_1 == mPins) {
+        LPC_PINCON->PINMODE_OD0 |= (3 << 0);
+        LPC_PINCON->PINMODE0 = (LPC_PINCON->PINMODE0 & ~(0xF << 0)) | (0xA << 0);
+    }
+    else {
+        LPC_PINCON->PINMODE_OD0 |= (3 << 19);
+        LPC_PINCON->PINMODE1 = (LPC_PINCON->PINMODE1 & ~(0xF << 6)) | (0xA << 6);
+    }
+    selectPins(true);
+
+    // Set I2C1 Peripheral Clock divider to 4
+    LPC_SC->PCLKSEL1 &= ~(3 << 6);
+    const unsigned int pclk = getCpuClock() / 4;
+
+    return I2C_Base::init(pclk, speedInKhz);
+}
+
+void I2C1::clearBus()
+{
+    // Switch the pins to GPIO while clocking out the bus, and then give them back to I2C
+    selectPins(false);
+    if(I2C1Pins_P0_0_P0_1 == mPins) {
+        clockOutBus(LPC_GPIO0, (1 << 0), (1 << 1));
+    }
+    else {
+        clockOutBus(LPC_GPIO0, (1 << 19), (1 << 20));
+    }
+    selectPins(true);
+}
+
+void I2C1::selectPins(bool useI2C)
+{
+    if(I2C1Pins_P0_0_P0_1 == mPins) {
+        LPC_PINCON->PINSEL0 &= ~(0xF << 0);
+        if(useI2C) {
+            LPC_PINCON->PINSEL0 |= (0xF << 0);  // SDA1, SCL1
+        }
+    }
+    else {
+        LPC_PINCON->PINSEL1 &= ~(0xF << 6);
+        if(useI2C) {
+            LPC_PINCON->PINSEL1 |= (0xF << 6);  // SDA1, SCL1
+        }
+    }
+}
+
+I2C1::I2C1() : I2C_Base((LPC_I2C_TypeDef*) LPC_I2C1_BASE),
+    mPins(I2C1Pins_P0_0_P0_1)
+{
+
+}
@@ -1,5 +1,6 @@
 #include "I2C2.hpp"
 #include "LPC17xx.h"
+#include "profiler.hpp"   // PROFILE_SCOPE()
 
 
 
@@ -14,6 +15,7 @@ extern "C"
 {
     void I2C2_IRQHandler()
     {
+        PROFILE_SCOPE("i2c2 isr");
         I2C2::getInstance().handleInterrupt();
     }
 }
@@ -32,6 +34,14 @@ bool I2C2::init(unsigned int speedInKhz)
     return I2C_Base::init(pclk, speedInKhz);
 }
 
+void I2C2::clearBus()
+{
+    // Switch the pins to GPIO while clocking out the bus, and then give them back to I2C
+    LPC_PINCON->PINSEL0 &= ~(0xF << 20);
+    clockOutBus(LPC_GPIO0, (1 << 10), (1 << 11));
+    LPC_PINCON->PINSEL0 |= (0xA << 20);
+}
+
 I2C2::I2C2() : I2C_Base((LPC_I2C_TypeDef*) LPC_I2C2_BASE)
 {
 
@@ -0,0 +1,374 @@
+#include <string.h>     // memset(), memmove()
+#include "adc0.h"
+#include "gpdma.h"
+#include "sysConfig.h"    // INTR_PRIORITY_ADC, TIMER0_US_PER_TICK
+
+
+
+#define ADC0_NUM_CHANNELS   8                   ///< Number of ADC channels
+#define ADC0_DONE_BIT       (1U << 31)          ///< DONE bit of the ADC data registers
+#define ADC0_MAX_CLOCK      (12 * 1000UL * 1000UL) ///< Maximum ADC clock (13Mhz is the limit)
+#define ADC0_CLOCKS_PER_CONVERSION  65          ///< ADC clocks needed to convert one channel
+
+static int mDmaChannel = -1;            ///< The DMA channel that copies the ADC data registers
+static unsigned int* mpRing = 0;        ///< The ring of sweeps, each with the data registers of 8 channels
+static gpdma_Lli* mpLli = 0;            ///< One linked list item per sweep, linked in a loop
+static unsigned char mChannelMask = 0;  ///< The channels sampled by burst mode
+
+/// Allocates the DMA resources, which only happens once
+static int adc0_BurstInit(void)
+{
+    if (0 == mpRing)
+    {
+        gpdma_Init();
+        mpRing = gpdma_Malloc(ADC0_BURST_SWEEPS * ADC0_NUM_CHANNELS * sizeof(*mpRing));
+        mpLli  = gpdma_Malloc(ADC0_BURST_SWEEPS * sizeof(*mpLli));
+        mDmaChannel = gpdma_AcquireChannel(0, 0, 0);
+    }
+
+    return (0 != mpRing && 0 != mpLli && mDmaChannel >= 0);
+}
+
+/// @returns the index of the last sweep completely written by the DMA
+static unsigned int adc0_GetLatestSweep(void)
+{
+    // The DMA destination is the sweep being written, so the previous sweep is complete
+    const unsigned int dst = gpdma_GetChannel(mDmaChannel)->DMACCDestAddr;
+    const unsigned int sweepBytes = ADC0_NUM_CHANNELS * sizeof(*mpRing);
+    const unsigned int writing = (dst - (unsigned int) mpRing) / sweepBytes;
+
+    return (0 == writing || writing >= ADC0_BURST_SWEEPS) ? (ADC0_BURST_SWEEPS - 1) : (writing - 1);
+}
+
+int adc0_StartBurst(unsigned char channelMask, unsigned int sampleRateHz)
+{
+    if (0 == channelMask || !adc0_BurstInit()) {
+        return 0;
+    }
+    adc0_StopBurst();
+    adc0_StopTriggered();
+
+    unsigned int highestChannel = 0;
+    unsigned int numChannels = 0;
+    for (unsigned int ch = 0; ch < ADC0_NUM_CHANNELS; ch++) {
+        if (channelMask & (1 << ch)) {
+            highestChannel = ch;
+            numChannels++;
+        }
+    }
+
+    /**
+     * At the end of a sweep, the ADC requests the DMA because the interrupt of the highest
+     * channel is enabled.  The DMA then copies ADDR0 up to the highest channel's data register
+     * to this sweep of the ring, and loads the LLI of the next sweep.
+     */
+    const unsigned int control = GPDMA_CTRL_SIZE(highestChannel + 1) |
+                                 GPDMA_CTRL_SRC_BURST(2) | GPDMA_CTRL_DST_BURST(2) |
+                                 GPDMA_CTRL_SRC_WIDTH(2) | GPDMA_CTRL_DST_WIDTH(2) |
+                                 GPDMA_CTRL_SRC_INC | GPDMA_CTRL_DST_INC;
+
+    // Samples without the DONE bit are not valid, so clearing the ring clears the history
+    memset(mpRing, 0, ADC0_BURST_SWEEPS * ADC0_NUM_CHANNELS * sizeof(*mpRing));
+    for (unsigned int i = 0; i < ADC0_BURST_SWEEPS; i++) {
+        mpLli[i].src = (unsigned int) &(LPC_ADC->ADDR0);
+        mpLli[i].dst = (unsigned int) &mpRing[i * ADC0_NUM_CHANNELS];
+        mpLli[i].pNext = &mpLli[(i + 1) % ADC0_BURST_SWEEPS];
+        mpLli[i].control = control;
+    }
+
+    // Burst rate is the ADC clock divided by the clocks needed to convert all channels
+    const unsigned int pclk = getCpuClock() / 4;
+    const unsigned int adcClock = (0 == sampleRateHz ? 1 : sampleRateHz) * ADC0_CLOCKS_PER_CONVERSION * numChannels;
+    unsigned int divider = (adcClock >= pclk) ? 1 : (pclk / adcClock);
+    while ((pclk / divider) > ADC0_MAX_CLOCK) {
+        divider++;
+    }
+    divider = (divider > 256) ? 256 : divider;
+
+    gpdma_Start(mDmaChannel, mpLli[0].src, mpLli[0].dst, &mpLli[1], control,
+                GPDMA_CFG_SRC_PERIPH(gpdma_adc) | GPDMA_CFG_P2M);
+
+    // The ADC interrupt is only used as DMA request, it is not enabled at the NVIC
+    LPC_SC->PCONP |= (1 << 12);
+    NVIC_DisableIRQ(ADC_IRQn);
+    LPC_ADC->ADINTEN = (1 << highestChannel);
+    mChannelMask = channelMask;
+    LPC_ADC->ADCR = channelMask | ((divider - 1) << 8) | (1 << 16) | (1 << 21);
+
+    return 1;
+}
+
+void adc0_StopBurst(void)
+{
+    if (0 == mChannelMask) {
+        return;
+    }
+
+    LPC_ADC->ADCR &= ~(1 << 16);
+    LPC_ADC->ADINTEN = (1 << 8);    // Reset value: global DONE flag generates the interrupt
+    gpdma_Stop(mDmaChannel);
+    mChannelMask = 0;
+}
+
+unsigned char adc0_GetBurstChannels(void)
+{
+    return mChannelMask;
+}
+
+unsigned short adc0_GetLatest(unsigned char channelNum)
+{
+    if (channelNum >= ADC0_NUM_CHANNELS || 0 == (mChannelMask & (1 << channelNum))) {
+        return 0;
+    }
+
+    const unsigned int sample = mpRing[adc0_GetLatestSweep() * ADC0_NUM_CHANNELS + channelNum];
+    return (sample & ADC0_DONE_BIT) ? ((sample >> 4) & 0xFFF) : 0;
+}
+
+unsigned int adc0_GetHistory(unsigned char channelNum, unsigned short* pSamples, unsigned int count)
+{
+    if (channelNum >= ADC0_NUM_CHANNELS || 0 == (mChannelMask & (1 << channelNum))) {
+        return 0;
+    }
+    if (count > ADC0_BURST_SWEEPS - 1) {
+        count = ADC0_BURST_SWEEPS - 1;
+    }
+
+    // Walk back from the latest sweep, filling the samples from the end of the caller's memory
+    unsigned int sweep = adc0_GetLatestSweep();
+    unsigned int found = 0;
+    while (found < count)
+    {
+        const unsigned int sample = mpRing[sweep * ADC0_NUM_CHANNELS + channelNum];
+        if (0 == (sample & ADC0_DONE_BIT)) {
+            break;
+        }
+        pSamples[count - 1 - found] = (sample >> 4) & 0xFFF;
+        found++;
+        sweep = (0 == sweep) ? (ADC0_BURST_SWEEPS - 1) : (sweep - 1);
+    }
+
+    // Move the samples to the beginning if fewer samples were found
+    if (found < count) {
+        memmove(pSamples, pSamples + (count - found), found * sizeof(*pSamples));
+    }
+    return found;
+}
+
+
+
+/**
+ * State of a channel in triggered mode.  The ISR is the only writer of the reading,
+ * and the tasks only read it, so no locking is needed.
+ */
+typedef struct {
+    unsigned int acc;               ///< Sum of the conversions of the current reading
+    unsigned int count;             ///< Number of conversions in acc
+    unsigned char filter;           ///< adc0_FilterType
+    unsigned char param;            ///< Window of moving average, or N of the IIR
+    unsigned char windowIdx;        ///< Next index of the moving average window
+    unsigned char windowFill;       ///< Number of readings in the moving average window
+    unsigned int windowSum;         ///< Sum of the readings in the moving average window
+    unsigned short window[ADC0_MAX_FILTER_WINDOW]; ///< The moving average window
+    int iir;                        ///< IIR filter output with 8 fraction bits
+    volatile unsigned short reading;        ///< The latest filtered 16-bit reading
+    volatile unsigned int readingCount;     ///< Number of readings produced
+} adc0_ChannelState;
+
+static adc0_ChannelState mChannels[ADC0_NUM_CHANNELS];     ///< State of each channel in triggered mode
+static unsigned char mNextChannel[ADC0_NUM_CHANNELS];      ///< The channel to convert after each channel
+static unsigned char mTriggeredMask = 0;    ///< The channels converted in triggered mode
+static unsigned int mOversampleShift = 0;   ///< log2 of the conversions per reading
+static unsigned int mTriggerPeriod = 0;     ///< Timer0 ticks between conversions
+
+/// Applies the filter of a channel to a new decimated reading @param x
+static inline unsigned short adc0_Filter(adc0_ChannelState* pCh, unsigned short x)
+{
+    switch (pCh->filter)
+    {
+        case adc0_FilterMovingAverage:
+            if (pCh->windowFill < pCh->param) {
+                pCh->windowFill++;
+            }
+            else {
+                pCh->windowSum -= pCh->window[pCh->windowIdx];
+            }
+            pCh->window[pCh->windowIdx] = x;
+            pCh->windowSum += x;
+            pCh->windowIdx = (pCh->windowIdx + 1) % pCh->param;
+            return pCh->windowSum / pCh->windowFill;
+
+        case adc0_FilterIir:
+            // Start from the first reading rather than slowly rising from zero
+            if (0 == pCh->readingCount) {
+                pCh->iir = (x << 8);
+            }
+            pCh->iir += ((int) (x << 8) - pCh->iir) >> pCh->param;
+            return (pCh->iir >> 8);
+
+        case adc0_FilterNone:
+        default:
+            return x;
+    }
+}
+
+/**
+ * Timer0 match 1 sets its match output to start the conversion, and this ISR clears
+ * it and schedules the next match one period after the previous match, so the
+ * conversions are evenly spaced even though this ISR's latency may vary.
+ */
+void ADC_IRQHandler(void)
+{
+    // Reading the global data register clears the DONE flag and the interrupt
+    const unsigned int gdr = LPC_ADC->ADGDR;
+    const unsigned int channel = (gdr >> 24) & 7;
+
+    LPC_TIM0->EMR &= ~(1 << 1);
+    LPC_TIM0->MR1 += mTriggerPeriod;
+    if ((LPC_TIM0->MR1 - LPC_TIM0->TC) > mTriggerPeriod) {
+        // Too late for the next period, so start again from now
+        LPC_TIM0->MR1 = LPC_TIM0->TC + mTriggerPeriod;
+    }
+    LPC_ADC->ADCR = (LPC_ADC->ADCR & ~0xFF) | (1 << mNextChannel[channel]);
+
+    adc0_ChannelState* pCh = &mChannels[channel];
+    pCh->acc += (gdr >> 4) & 0xFFF;
+    if (++pCh->count >= (1U << mOversampleShift))
+    {
+        // Scale the sum of the conversions to 16-bits
+        const unsigned short x = (pCh->acc << 4) >> mOversampleShift;
+        pCh->acc = 0;
+        pCh->count = 0;
+
+        pCh->reading = adc0_Filter(pCh, x);
+        pCh->readingCount++;
+    }
+}
+
+int adc0_StartTriggered(unsigned char channelMask, unsigned int readingRateHz, unsigned int oversample)
+{
+    unsigned int shift = 0;
+    while ((1U << shift) < oversample) {
+        shift++;
+    }
+    if (0 == channelMask || 0 == readingRateHz || oversample > ADC0_MAX_OVERSAMPLE ||
+        (1U << shift) != oversample || 0 == (LPC_TIM0->TCR & 1)) {
+        return 0;
+    }
+
+    unsigned int numChannels = 0;
+    unsigned int firstChannel = 0;
+    for (int ch = ADC0_NUM_CHANNELS - 1; ch >= 0; ch--) {
+        if (channelMask & (1 << ch)) {
+            firstChannel = ch;
+            numChannels++;
+        }
+    }
+
+    const unsigned int ticksPerSecond = (1000 * 1000UL) / TIMER0_US_PER_TICK;
+    const unsigned int period = ticksPerSecond / (readingRateHz * oversample * numChannels);
+    if (0 == period) {
+        return 0;
+    }
+
+    adc0_StopBurst();
+    adc0_StopTriggered();
+
+    // Each channel is followed by the next channel in the mask, wrapping around to the first
+    for (unsigned int ch = 0; ch < ADC0_NUM_CHANNELS; ch++) {
+        unsigned int next = (ch + 1) % ADC0_NUM_CHANNELS;
+        while (0 == (channelMask & (1 << next))) {
+            next = (next + 1) % ADC0_NUM_CHANNELS;
+        }
+        mNextChannel[ch] = next;
+
+        mChannels[ch].acc = 0;
+        mChannels[ch].count = 0;
+        mChannels[ch].readingCount = 0;
+        mChannels[ch].reading = 0;
+    }
+    mOversampleShift = shift;
+    mTriggerPeriod = period;
+    mTriggeredMask = channelMask;
+
+    const unsigned int pclk = getCpuClock() / 4;
+    unsigned int divider = 1;
+    while ((pclk / divider) > ADC0_MAX_CLOCK) {
+        divider++;
+    }
+
+    // Timer0 match 1 sets the match output, which starts the conversion on its rising edge
+    LPC_TIM0->EMR = (LPC_TIM0->EMR & ~((1 << 1) | (3 << 6))) | (2 << 6);
+    LPC_TIM0->MR1 = LPC_TIM0->TC + period;
+
+    LPC_SC->PCONP |= (1 << 12);
+    LPC_ADC->ADINTEN = (1 << 8);
+    LPC_ADC->ADCR = (1 << firstChannel) | ((divider - 1) << 8) | (1 << 21) | (4 << 24);
+
+    NVIC_SetPriority(ADC_IRQn, INTR_PRIORITY_ADC);
+    NVIC_EnableIRQ(ADC_IRQn);
+    return 1;
+}
+
+void adc0_StopTriggered(void)
+{
+    if (0 == mTriggeredMask) {
+        return;
+    }
+
+    NVIC_DisableIRQ(ADC_IRQn);
+    LPC_ADC->ADCR &= ~(7 << 24);
+    LPC_TIM0->EMR &= ~((1 << 1) | (3 << 6));
+    mTriggeredMask = 0;
+}
+
+unsigned char adc0_GetTriggeredChannels(void)
+{
+    return mTriggeredMask;
+}
+
+void adc0_SetFilter(unsigned char channelNum, adc0_FilterType filter, unsigned int param)
+{
+    if (channelNum >= ADC0_NUM_CHANNELS) {
+        return;
+    }
+
+    if (adc0_FilterMovingAverage == filter) {
+        param = (0 == param) ? 1 : (param > ADC0_MAX_FILTER_WINDOW) ? ADC0_MAX_FILTER_WINDOW : param;
+    }
+    else if (adc0_FilterIir == filter) {
+        param = (param > 8) ? 8 : param;
+    }
+
+    // Keep the ISR from using the filter while it changes
+    const int running = (0 != mTriggeredMask);
+    if (running) {
+        NVIC_DisableIRQ(ADC_IRQn);
+    }
+
+    adc0_ChannelState* pCh = &mChannels[channelNum];
+    pCh->filter = filter;
+    pCh->param = param;
+    pCh->windowIdx = 0;
+    pCh->windowFill = 0;
+    pCh->windowSum = 0;
+    pCh->iir = (pCh->reading << 8);
+
+    if (running) {
+        NVIC_EnableIRQ(ADC_IRQn);
+    }
+}
+
+unsigned short adc0_GetFiltered(unsigned char channelNum)
+{
+    if (channelNum >= ADC0_NUM_CHANNELS || 0 == (mTriggeredMask & (1 << channelNum))) {
+        return 0;
+    }
+
+    return mChannels[channelNum].reading;
+}
+
+unsigned int adc0_GetReadingCount(unsigned char channelNum)
+{
+    return (channelNum < ADC0_NUM_CHANNELS) ? mChannels[channelNum].readingCount : 0;
+}
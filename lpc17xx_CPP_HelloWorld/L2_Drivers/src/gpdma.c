@@ -0,0 +1,138 @@
+#include "gpdma.h"
+#include "sysConfig.h"  // INTR_PRIORITY_DMA
+
+
+
+/// Callbacks and their arguments for each DMA channel
+static gpdma_CallbackType mChannelCallbacks[GPDMA_NUM_CHANNELS];
+static void* mChannelCallbackArgs[GPDMA_NUM_CHANNELS];
+static unsigned char mChannelsUsedMask = 0;     ///< Bitmask of the acquired channels
+
+/// Memory pool in AHB SRAM for the gpdma_Malloc()
+static unsigned int mMemoryPool[GPDMA_MEMORY_POOL_BYTES / sizeof(unsigned int)] GPDMA_MEMORY;
+static unsigned int mMemoryPoolUsed = 0;    ///< Bytes used from mMemoryPool
+
+
+/**
+ * IRQ Handler needs to be named precisely to override "WEAK" ISR handler
+ * defined at cr_startup_lpc175x.cpp
+ */
+void DMA_IRQHandler(void)
+{
+    const unsigned int tcStatus  = LPC_GPDMA->DMACIntTCStat;
+    const unsigned int errStatus = LPC_GPDMA->DMACIntErrStat;
+    int ch = 0;
+
+    // Clear the interrupts we are about to handle
+    LPC_GPDMA->DMACIntTCClear = tcStatus;
+    LPC_GPDMA->DMACIntErrClr  = errStatus;
+
+    for (ch = 0; ch < GPDMA_NUM_CHANNELS; ch++)
+    {
+        const unsigned int mask = (1 << ch);
+        if ((tcStatus | errStatus) & mask)
+        {
+            if (mChannelCallbacks[ch])
+            {
+                mChannelCallbacks[ch](mChannelCallbackArgs[ch], (errStatus & mask));
+            }
+        }
+    }
+}
+
+void gpdma_Init(void)
+{
+    if (!(LPC_SC->PCONP & (1 << 29)))
+    {
+        LPC_SC->PCONP |= (1 << 29);         // Enable power to DMA
+        LPC_GPDMA->DMACIntTCClear = 0xFF;   // Clear any pending interrupts and errors
+        LPC_GPDMA->DMACIntErrClr  = 0xFF;
+        LPC_GPDMA->DMACConfig = (1 << 0);   // GP-DMA Enable with little-endian mode
+
+        // Priority needs to be low enough for the callbacks to use FreeRTOS API
+        NVIC_SetPriority(DMA_IRQn, INTR_PRIORITY_DMA);
+        NVIC_EnableIRQ(DMA_IRQn);
+    }
+}
+
+int gpdma_AcquireChannel(int highPriority, gpdma_CallbackType callback, void* pArg)
+{
+    int channel = -1;
+    int i = 0;
+
+    // Channel 0 has the highest priority, and channel 7 has the lowest priority
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    for (i = 0; i < GPDMA_NUM_CHANNELS && channel < 0; i++)
+    {
+        const int ch = highPriority ? i : (GPDMA_NUM_CHANNELS - 1 - i);
+        if (!(mChannelsUsedMask & (1 << ch)))
+        {
+            mChannelsUsedMask |= (1 << ch);
+            mChannelCallbacks[ch] = callback;
+            mChannelCallbackArgs[ch] = pArg;
+            channel = ch;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return channel;
+}
+
+void gpdma_Start(int channel, unsigned int src, unsigned int dst,
+                 const gpdma_Lli* pNextLli, unsigned int control, unsigned int config)
+{
+    LPC_GPDMACH_TypeDef* pCh = gpdma_GetChannel(channel);
+    const unsigned int mask = (1 << channel);
+    const unsigned int errIntrEnable = (1 << 14);
+    const unsigned int tcIntrEnable  = (1 << 15);
+    const unsigned int channelEnable = (1 << 0);
+
+    // Clear any pending interrupt and errors of this channel:
+    LPC_GPDMA->DMACIntTCClear = mask;
+    LPC_GPDMA->DMACIntErrClr  = mask;
+
+    pCh->DMACCSrcAddr  = src;
+    pCh->DMACCDestAddr = dst;
+    pCh->DMACCLLI      = (unsigned int) pNextLli;
+    pCh->DMACCControl  = control;
+    pCh->DMACCConfig   = config | errIntrEnable | tcIntrEnable | channelEnable;
+}
+
+void gpdma_Stop(int channel)
+{
+    gpdma_GetChannel(channel)->DMACCConfig &= ~(1 << 0);
+}
+
+int gpdma_IsBusy(int channel)
+{
+    return (LPC_GPDMA->DMACEnbldChns & (1 << channel));
+}
+
+void* gpdma_Malloc(unsigned int bytes)
+{
+    void* pMem = 0;
+
+    // Round up to 4 bytes so all allocations are word aligned
+    bytes = (bytes + 3) & ~3;
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    if (mMemoryPoolUsed + bytes <= sizeof(mMemoryPool))
+    {
+        pMem = (char*)mMemoryPool + mMemoryPoolUsed;
+        mMemoryPoolUsed += bytes;
+    }
+    __set_PRIMASK(primask);
+
+    return pMem;
+}
+
+int gpdma_IsAccessible(const void* pMem)
+{
+    const unsigned int addr = (unsigned int) pMem;
+    const unsigned int ahbSramStart = 0x2007C000;
+    const unsigned int ahbSramEnd   = 0x20084000;
+
+    return (addr >= ahbSramStart && addr < ahbSramEnd);
+}
@@ -0,0 +1,191 @@
+#include "hwtimer.h"
+#include "LPC17xx.h"
+#include "sysConfig.h"  // getCpuClock(), INTR_PRIORITY_HWTIMER
+
+
+
+static hwtimer_Timer* mpHead = 0;           ///< The running timers sorted by their deadline
+static unsigned int mMaxLateUs = 0;         ///< The maximum time a callback was late
+static char mInitialized = 0;               ///< Set once hwtimer_Init() is called
+
+/// @returns true if the time @param a is before the time @param b (handles the wrap-around)
+static inline int hwtimer_IsBefore(unsigned int a, unsigned int b)
+{
+    return (int) (a - b) < 0;
+}
+
+/// Removes the timer from the list of running timers (interrupts must be disabled)
+static void hwtimer_Remove(hwtimer_Timer* pTimer)
+{
+    hwtimer_Timer** ppLink = &mpHead;
+    while (0 != *ppLink)
+    {
+        if (*ppLink == pTimer) {
+            *ppLink = pTimer->pNext;
+            break;
+        }
+        ppLink = &((*ppLink)->pNext);
+    }
+    pTimer->running = 0;
+}
+
+/// Inserts the timer in the list of running timers by its deadline (interrupts must be disabled)
+static void hwtimer_Insert(hwtimer_Timer* pTimer)
+{
+    // Timers with the same deadline expire in the order they were started
+    hwtimer_Timer** ppLink = &mpHead;
+    while (0 != *ppLink && !hwtimer_IsBefore(pTimer->deadline, (*ppLink)->deadline)) {
+        ppLink = &((*ppLink)->pNext);
+    }
+
+    pTimer->pNext = *ppLink;
+    *ppLink = pTimer;
+    pTimer->running = 1;
+}
+
+/// Programs the match register for the timer at the head of the list (interrupts must be disabled)
+static void hwtimer_ProgramNext(void)
+{
+    if (0 == mpHead) {
+        LPC_TIM2->MCR &= ~(1 << 0);
+        return;
+    }
+
+    LPC_TIM2->MR0 = mpHead->deadline;
+    LPC_TIM2->MCR |= (1 << 0);
+
+    // The deadline may have passed before the match register was written
+    if (!hwtimer_IsBefore(LPC_TIM2->TC, mpHead->deadline)) {
+        NVIC_SetPendingIRQ(TIMER2_IRQn);
+    }
+}
+
+/// Starts the timer with its first expiry after @param delayUs
+static void hwtimer_Start(hwtimer_Timer* pTimer, unsigned int delayUs, unsigned int periodUs,
+                          hwtimer_Callback callback, void* pArg)
+{
+    if (!mInitialized) {
+        hwtimer_Init();
+    }
+
+    // Deadlines must be less than half of the counter range away to be sorted correctly
+    if (delayUs > 0x7FFFFFFF) {
+        delayUs = 0x7FFFFFFF;
+    }
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        if (pTimer->running) {
+            hwtimer_Remove(pTimer);
+        }
+
+        pTimer->deadline = LPC_TIM2->TC + delayUs;
+        pTimer->periodUs = periodUs;
+        pTimer->callback = callback;
+        pTimer->pArg = pArg;
+        hwtimer_Insert(pTimer);
+        hwtimer_ProgramNext();
+    }
+    __set_PRIMASK(primask);
+}
+
+/// Timer2 match 0 occurs at the deadline of the timer at the head of the list
+void TIMER2_IRQHandler(void)
+{
+    LPC_TIM2->IR = (1 << 0);
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+
+    unsigned int now = LPC_TIM2->TC;
+    while (0 != mpHead && !hwtimer_IsBefore(now, mpHead->deadline))
+    {
+        hwtimer_Timer* pTimer = mpHead;
+        mpHead = pTimer->pNext;
+        pTimer->running = 0;
+
+        const unsigned int lateUs = now - pTimer->deadline;
+        if (lateUs > mMaxLateUs) {
+            mMaxLateUs = lateUs;
+        }
+
+        // Re-insert a periodic timer before the callback so the callback can stop it
+        if (0 != pTimer->periodUs) {
+            pTimer->deadline += pTimer->periodUs;
+            if (!hwtimer_IsBefore(now, pTimer->deadline)) {
+                pTimer->deadline = now + pTimer->periodUs;
+            }
+            hwtimer_Insert(pTimer);
+        }
+
+        // Higher priority interrupts are allowed while the callback runs
+        __set_PRIMASK(primask);
+        pTimer->callback(pTimer->pArg);
+        __disable_irq();
+
+        now = LPC_TIM2->TC;
+    }
+
+    hwtimer_ProgramNext();
+    __set_PRIMASK(primask);
+}
+
+void hwtimer_Init(void)
+{
+    if (mInitialized) {
+        return;
+    }
+
+    LPC_SC->PCONP |= (1 << 22);         // Timer2 Power Enable
+    LPC_SC->PCLKSEL1 &= ~(3 << 12);
+    LPC_SC->PCLKSEL1 |=  (1 << 12);     // CLK / 1
+
+    LPC_TIM2->TCR = (1 << 1);           // Reset the counter
+    LPC_TIM2->PR = (getCpuClock() / (1000 * 1000UL)) - 1;  // Count microseconds
+    LPC_TIM2->MCR = 0;
+    LPC_TIM2->IR = 0x3F;
+    LPC_TIM2->TCR = (1 << 0);           // Enable the counter
+
+    NVIC_SetPriority(TIMER2_IRQn, INTR_PRIORITY_HWTIMER);
+    NVIC_EnableIRQ(TIMER2_IRQn);
+    mInitialized = 1;
+}
+
+unsigned int hwtimer_GetMicros(void)
+{
+    return LPC_TIM2->TC;
+}
+
+void hwtimer_StartOneShot(hwtimer_Timer* pTimer, unsigned int delayUs,
+                          hwtimer_Callback callback, void* pArg)
+{
+    hwtimer_Start(pTimer, delayUs, 0, callback, pArg);
+}
+
+void hwtimer_StartPeriodic(hwtimer_Timer* pTimer, unsigned int periodUs,
+                           hwtimer_Callback callback, void* pArg)
+{
+    if (periodUs < HWTIMER_MIN_PERIOD_US) {
+        periodUs = HWTIMER_MIN_PERIOD_US;
+    }
+    hwtimer_Start(pTimer, periodUs, periodUs, callback, pArg);
+}
+
+void hwtimer_Stop(hwtimer_Timer* pTimer)
+{
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        if (pTimer->running) {
+            hwtimer_Remove(pTimer);
+            hwtimer_ProgramNext();
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+unsigned int hwtimer_GetMaxLateUs(void)
+{
+    return mMaxLateUs;
+}
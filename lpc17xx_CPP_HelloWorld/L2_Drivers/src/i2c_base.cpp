@@ -1,21 +1,31 @@
+#include <stdlib.h>         // malloc()
+#include <string.h>         // memset(), memcpy()
 #include "i2c_base.hpp"
-#include <string.h>     // memcpy
-#include <stdio.h>  // debugging
+#include "sysConfig.h"      // TIMER0_US_PER_TICK, getCpuClock()
+#include "profiler.hpp"     // Profiler::getCycles()
+
+
+
+#define I2C_STAT_ARBITRATION_LOST   0x38    ///< I2STAT when arbitration is lost
+#define I2C_BUS_CLEAR_HALF_CLOCK_US 5       ///< SCL low/high time when clearing the bus (100Khz needs 4.7/4.0us minimum)
+
+
+/// @returns the Timer0 tick that is used to measure time of I2C transactions
+static inline unsigned int getTimerTick()
+{
+    return LPC_TIM0->TC;
+}
 
 void I2C_Base::handleInterrupt()
 {
     long higherPriorityTaskWaiting = 0;
     mI2CStateMachineStatusType status = i2cStateMachine();
 
-    /* For READ, do not release I2C Lock, instead give the i2cReadCompleteSignal
-     * so that the read() routine can read the data first, and then release the lock.
-     * For WRITE, release the i2c Lock so next task can access I2C
+    /* When the transaction completes, notify its owner and start
+     * the next transaction right here without any context switch.
      */
-    if(status == readComplete) {
-        xSemaphoreGiveFromISR(mReadCompSig, &higherPriorityTaskWaiting);
-    }
-    else if(status == writeComplete) {
-        xSemaphoreGiveFromISR(mI2CMutex, &higherPriorityTaskWaiting);
+    if(status == readComplete || status == writeComplete) {
+        completeTransaction(&higherPriorityTaskWaiting);
     }
     else {
         // I2C is busy ... do nothing
@@ -36,73 +46,121 @@ char I2C_Base::readReg(char deviceAddress, char registerAddress)
 
 bool I2C_Base::readRegisters(char deviceAddress, char firstReg, char* pData, unsigned int bytesToRead)
 {
-    if(bytesToRead > sizeof(mI2CIOFrame.rwBuffer)) {
-        return false;
+    return (0 == transfer(true, deviceAddress, firstReg, pData, bytesToRead));
+}
+
+char I2C_Base::writeReg(char deviceAddress, char registerAddress, char value)
+{
+    return transfer(false, deviceAddress, registerAddress, &value, 1);
+}
+
+bool I2C_Base::writeRegisters(char deviceAddress, char firstReg, const char* pData, unsigned int bytesToWrite)
+{
+    // Data is only read from pData during the write operation
+    return (0 == transfer(false, deviceAddress, firstReg, (char*)pData, bytesToWrite));
+}
+
+void I2C_Base::readAsync(I2C_Transaction& t, char deviceAddress, char firstReg, char* pData, unsigned int bytesToRead,
+                         I2C_CallbackType callback, void* pArg, xSemaphoreHandle doneSignal)
+{
+    t.slaveAddress  = deviceAddress;
+    t.firstRegister = firstReg;
+    t.isRead        = true;
+    t.pData         = pData;
+    t.length        = bytesToRead;
+    t.callback      = callback;
+    t.pCallbackArg  = pArg;
+    t.doneSignal    = doneSignal;
+    t.notifyTask    = 0;
+    t.timeoutMs     = 0;
+    submit(t);
+}
+
+void I2C_Base::writeAsync(I2C_Transaction& t, char deviceAddress, char firstReg, const char* pData, unsigned int bytesToWrite,
+                          I2C_CallbackType callback, void* pArg, xSemaphoreHandle doneSignal)
+{
+    readAsync(t, deviceAddress, firstReg, (char*)pData, bytesToWrite, callback, pArg, doneSignal);
+    t.isRead = false;
+}
+
+void I2C_Base::submit(I2C_Transaction& t)
+{
+    t.error = 0;
+    t.done  = false;
+    t.pNext = 0;
+    t.submitTime = getTimerTick();
+
+    lockQueue();
+    {
+        // Start the transaction if the bus is idle, otherwise the ISR will start it
+        if(0 == mpQueueHead) {
+            mpQueueHead = mpQueueTail = &t;
+            i2cKickOffTransfer(t);
+        }
+        else {
+            mpQueueTail->pNext = &t;
+            mpQueueTail = &t;
+        }
     }
+    unlockQueue();
+}
 
-    // If scheduler not running, perform polling transaction
+void I2C_Base::flush()
+{
     if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
     {
         NVIC_DisableIRQ(mIRQ);
-        {
-            i2cKickOffTransfer(i2cRead, deviceAddress, firstReg, pData, bytesToRead);
-            do {
-                // Wait until SI flag is set, then call i2cStateMachine()
-                while(! (mpI2CRegs->I2CONSET & (1 << 3)) )
-                {
-                    ;
-                }
-            }while (readComplete != i2cStateMachine());
-        }
-        memcpy(pData, &mI2CIOFrame.rwBuffer[0], bytesToRead);
+        pollUntilDone(0);
         NVIC_EnableIRQ(mIRQ);
-        return (0 == mI2CIOFrame.error);
+        return;
     }
 
-    // Wait to get I2C Access, and take clear read complete signal if it's available
+    // Only one task at a time waits to be notified when the queue becomes empty
     xSemaphoreTake(mI2CMutex, portMAX_DELAY);
-    xSemaphoreTake(mReadCompSig, 0);
-
-    // Kick off the transfer and wait for read to finish
-    i2cKickOffTransfer(i2cRead, deviceAddress, firstReg, pData, bytesToRead);
-    xSemaphoreTake(mReadCompSig, OS_MS(I2C_READ_TIMEOUT_MS));
+    {
+        bool idle = false;
+        ulTaskNotifyTake(pdTRUE, 0);
+        lockQueue();
+        {
+            idle = (0 == mpQueueHead);
+            mIdleWaitingTask = idle ? 0 : xTaskGetCurrentTaskHandle();
+        }
+        unlockQueue();
 
-    // Transfer is successful if error is nonzero
-    const bool success = (0 == mI2CIOFrame.error);
-    if(success) {
-        memcpy(pData, &mI2CIOFrame.rwBuffer[0], bytesToRead);
+        // Check the deadline of the active transaction while waiting
+        while(!idle && 0 == ulTaskNotifyTake(pdTRUE, OS_MS(I2C_TIMEOUT_MS))) {
+            checkDeadline();
+            idle = (0 == mpQueueHead);
+        }
+        mIdleWaitingTask = 0;
     }
-
-    // After read is done, give the I2C access back.
     xSemaphoreGive(mI2CMutex);
-
-    return success;
 }
 
-char I2C_Base::writeReg(char deviceAddress, char registerAddress, char value)
+void I2C_Base::checkDeadline()
 {
-    // If scheduler not running , perform polling transaction
-    if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
+    long notUsed = 0;
+    lockQueue();
     {
-        NVIC_DisableIRQ(mIRQ);
+        const I2C_Transaction* pActive = mpQueueHead;
+        if(0 != pActive)
         {
-            i2cKickOffTransfer(i2cWrite, deviceAddress, registerAddress, &value, 1);
-            do {
-                // Wait until SI flag is set, then call i2cStateMachine()
-                while(! (mpI2CRegs->I2CONSET & (1 << 3)) )
-                {
-                    ;
-                }
-            }while (writeComplete != i2cStateMachine());
+            const unsigned int timeoutMs = (0 == pActive->timeoutMs) ? I2C_TIMEOUT_MS : pActive->timeoutMs;
+            const unsigned int elapsedTicks = getTimerTick() - mActiveStartTime;
+            if(elapsedTicks >= (timeoutMs * 1000) / TIMER0_US_PER_TICK) {
+                mI2CIOFrame.error = I2C_ERROR_TIMEOUT;
+                completeTransaction(&notUsed);
+            }
         }
-        NVIC_EnableIRQ(mIRQ);
-        return true;
     }
+    unlockQueue();
+}
 
-    // Wait for I2C Access, and just return, I2C Lock will be given by ISR()
-    xSemaphoreTake(mI2CMutex, portMAX_DELAY);
-    i2cKickOffTransfer(i2cWrite, deviceAddress, registerAddress, &value, 1);
-    return 0;
+void I2C_Base::resetStats()
+{
+    lockQueue();
+    memset(&mStats, 0, sizeof(mStats));
+    unlockQueue();
 }
 
 char I2C_Base::isDevicePresent(char deviceAddress)
@@ -115,13 +173,21 @@ char I2C_Base::isDevicePresent(char deviceAddress)
 }
 
 I2C_Base::I2C_Base(LPC_I2C_TypeDef* pI2CBaseAddr) :
-        mpI2CRegs(pI2CBaseAddr)
+        mpI2CRegs(pI2CBaseAddr),
+        mIdleWaitingTask(0),
+        mpQueueHead(0),
+        mpQueueTail(0),
+        mActiveStartTime(0),
+        mpSlaveReading(0),
+        mSlaveActive(0),
+        mSlaveWindowSize(0),
+        mSlaveOffset(0),
+        mSlaveGotRegister(false)
 {
-    mI2CMutex = xSemaphoreCreateMutex();
-    vSemaphoreCreateBinary(mReadCompSig);
+    mpSlaveBuff[0] = mpSlaveBuff[1] = 0;
+    memset(&mStats, 0, sizeof(mStats));
 
-    /// Binary semaphore needs to be taken after creating it
-    xSemaphoreTake(mReadCompSig, 0);
+    mI2CMutex = xSemaphoreCreateMutex();
 
     if((unsigned int)mpI2CRegs == LPC_I2C0_BASE)
     {
@@ -140,6 +206,65 @@ I2C_Base::I2C_Base(LPC_I2C_TypeDef* pI2CBaseAddr) :
     }
 }
 
+bool I2C_Base::initSlave(char slaveAddress, unsigned int windowSize)
+{
+    if(0 != mSlaveWindowSize || 0 == windowSize) {
+        return false;
+    }
+
+    mpSlaveBuff[0] = (char*) malloc(windowSize);
+    mpSlaveBuff[1] = (char*) malloc(windowSize);
+    if(0 == mpSlaveBuff[0] || 0 == mpSlaveBuff[1]) {
+        free(mpSlaveBuff[0]);
+        free(mpSlaveBuff[1]);
+        mpSlaveBuff[0] = mpSlaveBuff[1] = 0;
+        return false;
+    }
+    memset(mpSlaveBuff[0], 0, windowSize);
+    memset(mpSlaveBuff[1], 0, windowSize);
+
+    lockQueue();
+    {
+        mSlaveWindowSize = windowSize;
+        mpI2CRegs->I2ADR0 = (slaveAddress & 0xFE);  // General call is not used
+        mpI2CRegs->I2MASK0 = 0;
+        mpI2CRegs->I2CONSET = 0x04;                 // Set AA to acknowledge our address
+    }
+    unlockQueue();
+
+    return true;
+}
+
+bool I2C_Base::updateSlaveWindow(const char* pData, unsigned int len)
+{
+    if(0 == mSlaveWindowSize) {
+        return false;
+    }
+    if(len > mSlaveWindowSize) {
+        len = mSlaveWindowSize;
+    }
+
+    // The back buffer may still be read by a master that started before the last update
+    const unsigned char back = mSlaveActive ^ 1;
+    bool backInUse = false;
+    lockQueue();
+    backInUse = (mpSlaveReading == mpSlaveBuff[back]);
+    unlockQueue();
+    if(backInUse) {
+        return false;
+    }
+
+    // ISR only starts using the active buffer, so the back buffer can be written without locking
+    memcpy(mpSlaveBuff[back], pData, len);
+    memcpy(mpSlaveBuff[back] + len, mpSlaveBuff[mSlaveActive] + len, mSlaveWindowSize - len);
+
+    lockQueue();
+    mSlaveActive = back;
+    unlockQueue();
+
+    return true;
+}
+
 bool I2C_Base::init(unsigned int pclk, unsigned int busRateInKhz)
 {
     // Power on I2C
@@ -165,6 +290,7 @@ bool I2C_Base::init(unsigned int pclk, unsigned int busRateInKhz)
 
     // Finally, enable I2C and enable Interrupts for this I2C
     mpI2CRegs->I2CONSET = 0x40;
+    NVIC_SetPriority(mIRQ, INTR_PRIORITY_I2C);
     NVIC_EnableIRQ(mIRQ);
 
     return true;
@@ -172,26 +298,251 @@ bool I2C_Base::init(unsigned int pclk, unsigned int busRateInKhz)
 
 
 
+void I2C_Base::clockOutBus(LPC_GPIO_TypeDef* pGpio, unsigned int sdaMask, unsigned int sclMask)
+{
+    /**
+     * Wait for half of the clock period using the CPU cycle counter, since a Timer0 tick is
+     * too coarse for this.  The cycle counter is enabled here in case the profiler isn't yet.
+     */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    PROFILER_DWT_CTRL |= (1 << 0);
+    const unsigned int halfClockCycles = (getCpuClock() / (1000 * 1000UL)) * I2C_BUS_CLEAR_HALF_CLOCK_US;
+    #define waitHalfClock()     do { const unsigned int start = Profiler::getCycles();              \
+                                     while((Profiler::getCycles() - start) < halfClockCycles); } while(0)
+
+    // Only drive the pins low since I2C is open-drain
+    pGpio->FIOCLR = (sdaMask | sclMask);
+    pGpio->FIODIR &= ~(sdaMask | sclMask);
+
+    // Clock out up to 9 bits until the slave releases SDA
+    for(int i = 0; i < 9 && !(pGpio->FIOPIN & sdaMask); i++)
+    {
+        pGpio->FIODIR |= sclMask;
+        waitHalfClock();
+        pGpio->FIODIR &= ~sclMask;
+        waitHalfClock();
+    }
+
+    // Generate STOP: SDA goes from low to high while SCL is high
+    pGpio->FIODIR |= sdaMask;
+    waitHalfClock();
+    pGpio->FIODIR &= ~sdaMask;
+    waitHalfClock();
+
+    #undef waitHalfClock
+}
+
+
+
 /// Private ///
 
-void I2C_Base::i2cKickOffTransfer(mI2cModeType mode, char devAddr, char regStart, char* pBytes, int len)
+char I2C_Base::transfer(bool isRead, char devAddr, char regStart, char* pBytes, unsigned int len)
 {
-    if(len <= I2C_FRAME_MAX_DATABYTES)
+    I2C_Transaction t;
+    t.slaveAddress  = devAddr;
+    t.firstRegister = regStart;
+    t.isRead        = isRead;
+    t.pData         = pBytes;
+    t.length        = len;
+    t.callback      = 0;
+    t.pCallbackArg  = 0;
+    t.doneSignal    = 0;
+    t.notifyTask    = 0;
+    t.timeoutMs     = 0;
+
+    // If scheduler not running, perform polling transaction
+    if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
     {
-        mI2CIOFrame.error           = 0;
-        mI2CIOFrame.mode            = mode;
-        mI2CIOFrame.slaveAddress    = devAddr;
-        mI2CIOFrame.firstRegister   = regStart;
-        mI2CIOFrame.bytesToTransfer = len;
-        mI2CIOFrame.bytePointer     = 0;
-
-        // Copy data to write into I2C Buffer.
-        if(i2cWrite == mode) {
-            memcpy(mI2CIOFrame.rwBuffer, pBytes, len);
+        NVIC_DisableIRQ(mIRQ);
+        {
+            submit(t);
+            pollUntilDone(&t);
+        }
+        NVIC_EnableIRQ(mIRQ);
+        return t.error;
+    }
+
+    // Clear any notification left over from before, so only ours wakes us up
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    /**
+     * Queue the transfer and wait for it to finish.  While waiting, check the deadline of
+     * the active transaction, which may be ours or another one ahead of ours in the queue,
+     * so the wait is bounded by the deadlines of the transactions ahead of us.
+     */
+    t.notifyTask = xTaskGetCurrentTaskHandle();
+    submit(t);
+    while(!t.done)
+    {
+        if(0 == ulTaskNotifyTake(pdTRUE, OS_MS(I2C_TIMEOUT_MS))) {
+            checkDeadline();
+        }
+    }
+
+    return t.error;
+}
+
+void I2C_Base::i2cKickOffTransfer(const I2C_Transaction& t)
+{
+    mI2CIOFrame.error           = 0;
+    mI2CIOFrame.mode            = t.isRead ? i2cRead : i2cWrite;
+    mI2CIOFrame.slaveAddress    = t.slaveAddress;
+    mI2CIOFrame.firstRegister   = t.firstRegister;
+    mI2CIOFrame.pBuffer         = t.pData;
+    mI2CIOFrame.bytesToTransfer = t.length;
+    mI2CIOFrame.bytePointer     = 0;
+    mActiveStartTime = getTimerTick();
+
+    /**
+     * Send START, I2C State Machine will finish the rest.
+     * If STOP of the previous transaction is still pending, the I2C peripheral
+     * sends the STOP first, and then the START.
+     */
+    mpI2CRegs->I2CONSET = 0x20;
+}
+
+void I2C_Base::completeTransaction(long* pHigherPriorityTaskWoken)
+{
+    I2C_Transaction* pDone = mpQueueHead;
+    if(0 == pDone) {
+        return;
+    }
+
+    // Read the completion info before marking it done since its memory may be re-used after that
+    const char error = mI2CIOFrame.error;
+    const unsigned char errorCode = (unsigned char)error;
+    updateStats(*pDone, error);
+    const I2C_CallbackType callback = pDone->callback;
+    void* pArg = pDone->pCallbackArg;
+    const xSemaphoreHandle doneSignal = pDone->doneSignal;
+    const xTaskHandle notifyTask = pDone->notifyTask;
+
+    /**
+     * Recover the bus before starting the next transaction:
+     *  - A timeout may be due to a slave holding the bus, so clear the bus lines.
+     *  - After arbitration loss or bus error, the I2C peripheral needs to be reset.
+     */
+    if(I2C_ERROR_TIMEOUT == errorCode || I2C_ERROR_BUS == errorCode) {
+        recoverBus(true);
+    }
+    else if(I2C_STAT_ARBITRATION_LOST == errorCode) {
+        recoverBus(false);
+    }
+
+    // Start the next transaction right away
+    mpQueueHead = pDone->pNext;
+    if(0 == mpQueueHead) {
+        mpQueueTail = 0;
+    }
+    else {
+        i2cKickOffTransfer(*mpQueueHead);
+    }
+
+    pDone->error = error;
+    pDone->done = true;
+
+    if(0 != callback) {
+        callback(pArg, error);
+    }
+    if(0 != doneSignal) {
+        xSemaphoreGiveFromISR(doneSignal, pHigherPriorityTaskWoken);
+    }
+    if(0 != notifyTask) {
+        vTaskNotifyGiveFromISR(notifyTask, pHigherPriorityTaskWoken);
+    }
+    if(0 == mpQueueHead && 0 != mIdleWaitingTask) {
+        vTaskNotifyGiveFromISR(mIdleWaitingTask, pHigherPriorityTaskWoken);
+    }
+}
+
+void I2C_Base::recoverBus(bool clearBusLines)
+{
+    ++mStats.busRecoveries;
+    if(clearBusLines) {
+        clearBus();
+    }
+    resetPeripheral();
+}
+
+void I2C_Base::resetPeripheral()
+{
+    mpI2CRegs->I2CONCLR = 0x6C;     // Clear ALL I2C Flags and disable I2C, which releases the bus
+
+    // Enable I2C, and keep acknowledging our slave address if slave mode is enabled
+    mpSlaveReading = 0;
+    mpI2CRegs->I2CONSET = (0 != mSlaveWindowSize) ? 0x44 : 0x40;
+}
+
+void I2C_Base::updateStats(const I2C_Transaction& t, char error)
+{
+    const unsigned int now = getTimerTick();
+    const unsigned int latencyUs = (now - t.submitTime) * TIMER0_US_PER_TICK;
+    const unsigned int busTimeUs = (now - mActiveStartTime) * TIMER0_US_PER_TICK;
+
+    ++mStats.transactions;
+    mStats.lastLatencyUs = latencyUs;
+    if(latencyUs > mStats.maxLatencyUs) {
+        mStats.maxLatencyUs = latencyUs;
+    }
+    if(busTimeUs > mStats.maxBusTimeUs) {
+        mStats.maxBusTimeUs = busTimeUs;
+    }
+
+    if(0 != error)
+    {
+        ++mStats.errors;
+        switch((unsigned char)error)
+        {
+            case I2C_ERROR_TIMEOUT:         ++mStats.timeouts;          break;
+            case I2C_ERROR_BUS:             ++mStats.busErrors;         break;
+            case I2C_STAT_ARBITRATION_LOST:
+            case 0x68: case 0x78: case 0xB0:    // Lost arbitration, and then addressed as a slave
+                ++mStats.arbitrationLost;
+                break;
+            case 0x20:  // Slave address NACKed
+            case 0x30:  // Data NACKed by slave
+            case 0x48:  // Read-mode slave address NACKed
+                ++mStats.nacks;
+                break;
+            default:
+                break;
         }
+    }
+}
 
-        // Send START, I2C State Machine will finish the rest.
-        mpI2CRegs->I2CONSET = 0x20;
+void I2C_Base::pollUntilDone(I2C_Transaction* pTrans)
+{
+    long notUsed = 0;
+    while(0 != mpQueueHead && (0 == pTrans || !pTrans->done))
+    {
+        // Wait until SI flag is set, then call i2cStateMachine()
+        while(! (mpI2CRegs->I2CONSET & (1 << 3)) && 0 != mpQueueHead)
+        {
+            checkDeadline();
+        }
+        if(0 != mpQueueHead && busy != i2cStateMachine()) {
+            completeTransaction(&notUsed);
+        }
+    }
+}
+
+void I2C_Base::lockQueue()
+{
+    if(taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        taskENTER_CRITICAL();
+    }
+    else {
+        __disable_irq();
+    }
+}
+
+void I2C_Base::unlockQueue()
+{
+    if(taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        taskEXIT_CRITICAL();
+    }
+    else {
+        __enable_irq();
     }
 }
 
@@ -236,11 +587,15 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
     #define setSTARTFlag()      mpI2CRegs->I2CONSET = (1<<5)
     #define clearSTARTFlag()    mpI2CRegs->I2CONCLR = (1<<5)
 
-    // busInUse is only set to 0 for write operation since read operation should set to 0 itself
+    /**
+     * Transaction completes as soon as STOP is requested, and we do not wait for the STOP
+     * to go out on the bus.  If the next transaction sets START while STOP is still pending,
+     * the I2C peripheral sends the STOP first, and then the START.
+     */
+    // AA is set along with STOP to keep acknowledging our slave address if slave mode is enabled
     #define setStop()           clearSTARTFlag();                       \
-                                mpI2CRegs->I2CONSET = (1<<4);           \
+                                mpI2CRegs->I2CONSET = (0 != mSlaveWindowSize) ? ((1<<4) | (1<<2)) : (1<<4); \
                                 clearSIFlag();                          \
-                                while((mpI2CRegs->I2CONSET&(1<<4)));    \
                                 if(i2cRead == mI2CIOFrame.mode)         \
                                     state = readComplete;               \
                                 else                                    \
@@ -282,7 +637,7 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
                     setStop();
                 }
                 else {
-                    mpI2CRegs->I2DAT = mI2CIOFrame.rwBuffer[mI2CIOFrame.bytePointer++];
+                    mpI2CRegs->I2DAT = mI2CIOFrame.pBuffer[mI2CIOFrame.bytePointer++];
                     clearSIFlag();
                 }
             }
@@ -306,7 +661,7 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
             setStop();
             break;
         case dataAvailableAckSent:
-            mI2CIOFrame.rwBuffer[mI2CIOFrame.bytePointer++] = mpI2CRegs->I2DAT;
+            mI2CIOFrame.pBuffer[mI2CIOFrame.bytePointer++] = mpI2CRegs->I2DAT;
             if(mI2CIOFrame.bytePointer >= (mI2CIOFrame.bytesToTransfer-1)) {    // Only 1 more byte remaining
                 mpI2CRegs->I2CONCLR = 0x04; // NACK next byte --> Next state: dataAvailableNackSent
             }
@@ -316,13 +671,14 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
             clearSIFlag();
             break;
         case dataAvailableNackSent: // Read last-byte from Slave
-            mI2CIOFrame.rwBuffer[mI2CIOFrame.bytePointer++] = mpI2CRegs->I2DAT;
+            mI2CIOFrame.pBuffer[mI2CIOFrame.bytePointer++] = mpI2CRegs->I2DAT;
             setStop();
             break;
 
 
         case busError:
-            mI2CIOFrame.error = mpI2CRegs->I2STAT;
+            // I2STAT is 0 upon bus error, so use a non-zero error code
+            mI2CIOFrame.error = I2C_ERROR_BUS;
             setStop();
             break;
         case arbitrationLost:
@@ -331,6 +687,20 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
             state = mI2CIOFrame.mode == i2cRead ? readComplete : writeComplete;
             mI2CIOFrame.error = mpI2CRegs->I2STAT;
             break;
+
+        // Lost arbitration as a master, and then addressed by the other master as a slave
+        case 0x68: case 0x78: case 0xB0:
+            if(0 != mpQueueHead) {
+                mI2CIOFrame.error = mpI2CRegs->I2STAT;
+                state = mI2CIOFrame.mode == i2cRead ? readComplete : writeComplete;
+            }
+            slaveStateMachine(mpI2CRegs->I2STAT);
+            break;
+        case 0x60: case 0x70: case 0x80: case 0x88: case 0x90: case 0x98:
+        case 0xA0: case 0xA8: case 0xB8: case 0xC0: case 0xC8:
+            slaveStateMachine(mpI2CRegs->I2STAT);
+            break;
+
         default:
             mI2CIOFrame.error = mpI2CRegs->I2STAT;
             setStop();
@@ -340,5 +710,57 @@ I2C_Base::mI2CStateMachineStatusType I2C_Base::i2cStateMachine()
     return state;
 }
 
+/*
+ * Slave Receiver states:
+ *  0x60 : Own address + W received            0x70 : General call received
+ *  0x80 : Data received, ACK returned         0x90 : General call data received, ACK returned
+ *  0x88 : Data received, NACK returned        0x98 : General call data received, NACK returned
+ *  0xA0 : STOP or repeated START received
+ *
+ * Slave Transmitter states:
+ *  0xA8 : Own address + R received, ACK returned
+ *  0xB8 : Data transmitted, ACK received
+ *  0xC0 : Data transmitted, NACK received (master is done reading)
+ *  0xC8 : Last data transmitted with AA=0, ACK received
+ */
+void I2C_Base::slaveStateMachine(unsigned int i2cState)
+{
+    switch(i2cState)
+    {
+        // Master is writing to us: first byte is the register of the window to read next
+        case 0x60: case 0x68: case 0x70: case 0x78:
+            mSlaveGotRegister = false;
+            break;
+        case 0x80: case 0x90:
+            // Window is read-only, so the rest of the written bytes are ignored
+            if(!mSlaveGotRegister) {
+                mSlaveOffset = mpI2CRegs->I2DAT;
+                mSlaveGotRegister = true;
+            }
+            break;
 
+        // Master starts reading: keep using the latest buffer until the master is done
+        case 0xA8: case 0xB0:
+            mpSlaveReading = mpSlaveBuff[mSlaveActive];
+            ++mStats.slaveReads;
+            // No break, send the first byte
+        case 0xB8:
+        {
+            const char* pWindow = mpSlaveReading;
+            mpI2CRegs->I2DAT = (0 != pWindow && mSlaveOffset < mSlaveWindowSize) ? pWindow[mSlaveOffset] : 0xFF;
+            mSlaveOffset++;
+            break;
+        }
+        case 0xC0: case 0xC8:
+            mpSlaveReading = 0;
+            break;
 
+        case 0x88: case 0x98: case 0xA0:
+        default:
+            break;
+    }
+
+    // Keep acknowledging our address and data, and continue
+    mpI2CRegs->I2CONSET = (1<<2);
+    mpI2CRegs->I2CONCLR = (1<<3);
+}
@@ -0,0 +1,137 @@
+#include "rit.h"
+#include "LPC17xx.h"
+#include "sysConfig.h"  // getCpuClock(), INTR_PRIORITY_RIT
+
+
+
+/// A callback added to the RIT
+typedef struct {
+    rit_Callback callback;      ///< The function to call
+    unsigned int periodMs;      ///< The period of the callback
+    unsigned int elapsedMs;     ///< Milliseconds elapsed since the callback was last called
+} rit_Client;
+
+static rit_Client mClients[RIT_MAX_CALLBACKS];  ///< The callbacks added to the RIT
+static unsigned int mTickMs = 0;                ///< The period of the RIT interrupt
+
+/// @returns the greatest common divisor of @param a and @param b
+static unsigned int rit_Gcd(unsigned int a, unsigned int b)
+{
+    while (0 != b) {
+        const unsigned int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/// Sets the RIT period to the greatest common divisor of all the callback periods
+static void rit_UpdateTick(void)
+{
+    unsigned int tickMs = 0;
+    for (int i = 0; i < RIT_MAX_CALLBACKS; i++) {
+        if (0 != mClients[i].callback) {
+            tickMs = rit_Gcd(mClients[i].periodMs, tickMs);
+        }
+    }
+
+    if (0 == tickMs) {
+        NVIC_DisableIRQ(RIT_IRQn);
+        LPC_RIT->RICTRL = 0;
+    }
+    else if (tickMs != mTickMs) {
+        // Power up first otherwise writing to RIT will give us Hard Fault
+        LPC_SC->PCONP |= (1 << 16);
+
+        // Enable CLK/1 to simplify RICOMPVAL calculation below
+        LPC_SC->PCLKSEL1 &= ~(3 << 26);
+        LPC_SC->PCLKSEL1 |=  (1 << 26);
+
+        LPC_RIT->RICTRL = 0;
+        LPC_RIT->RICOUNTER = 0;
+        LPC_RIT->RIMASK = 0;
+        LPC_RIT->RICOMPVAL = (getCpuClock() / 1000) * tickMs;
+
+        // Clear timer upon match, and enable timer
+        LPC_RIT->RICTRL = (1 << 0) | (1 << 1) | (1 << 3);
+
+        NVIC_SetPriority(RIT_IRQn, INTR_PRIORITY_RIT);
+        NVIC_EnableIRQ(RIT_IRQn);
+    }
+    mTickMs = tickMs;
+}
+
+void RIT_IRQHandler(void)
+{
+    // Clear Interrupt Flag
+    LPC_RIT->RICTRL |= (1 << 0);
+
+    for (int i = 0; i < RIT_MAX_CALLBACKS; i++)
+    {
+        rit_Client* pClient = &mClients[i];
+        if (0 == pClient->callback) {
+            continue;
+        }
+
+        pClient->elapsedMs += mTickMs;
+        if (pClient->elapsedMs >= pClient->periodMs) {
+            pClient->elapsedMs = 0;
+            pClient->callback();
+        }
+    }
+}
+
+int rit_AddCallback(rit_Callback callback, unsigned int periodMs)
+{
+    int added = 0;
+    if (0 == periodMs) {
+        periodMs = 1;
+    }
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        for (int i = 0; i < RIT_MAX_CALLBACKS; i++) {
+            if (0 == mClients[i].callback) {
+                mClients[i].periodMs = periodMs;
+                mClients[i].elapsedMs = 0;
+                mClients[i].callback = callback;
+                added = 1;
+                break;
+            }
+        }
+        if (added) {
+            rit_UpdateTick();
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return added;
+}
+
+int rit_RemoveCallback(rit_Callback callback)
+{
+    int removed = 0;
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        for (int i = 0; i < RIT_MAX_CALLBACKS; i++) {
+            if (callback == mClients[i].callback) {
+                mClients[i].callback = 0;
+                removed = 1;
+            }
+        }
+        if (removed) {
+            rit_UpdateTick();
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return removed;
+}
+
+unsigned int rit_GetTickMs(void)
+{
+    return mTickMs;
+}
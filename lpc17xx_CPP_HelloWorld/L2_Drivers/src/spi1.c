@@ -1,28 +1,196 @@
+#include <string.h>     // memcpy()
 #include "spi1.h"
 #include "sysConfig.h"
+#include "task.h"       // xTaskGetSchedulerState(), task notifications
+
+#if SPI1_USE_DMA
+#include "gpdma.h"
+
+
+
+static int mDmaTxChannel = -1;              ///< DMA channel that feeds the SSP1 Tx FIFO
+static int mDmaRxChannel = -1;              ///< DMA channel that empties the SSP1 Rx FIFO
+static unsigned char* mpDmaBounce = 0;      ///< DMA accessible buffer for data in the local SRAM
+static unsigned char* mpDmaFill = 0;        ///< DMA accessible 0xFF byte to send, followed by a byte to discard Rx data
+static xTaskHandle mDmaWaitingTask = 0;     ///< Notified by the DMA interrupt when the Rx DMA completes
+static char mDmaInitialized = 0;            ///< Set once the DMA resources are allocated
+static volatile int mDmaError = 0;          ///< Set by the DMA interrupt if the transfer failed
+
+/// Callback from the DMA interrupt when the Rx DMA completes, which means all data was exchanged
+static void spi1_DmaComplete(void* pArg, int error)
+{
+    portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+    mDmaError = error;
+
+    if (0 != mDmaWaitingTask) {
+        vTaskNotifyGiveFromISR(mDmaWaitingTask, &higherPriorityTaskWoken);
+    }
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+}
+
+/// Allocates the DMA resources, which only happens once even if spi1_Init() is called again
+static void spi1_DmaInit(void)
+{
+    if (mDmaInitialized) {
+        return;
+    }
+
+    mDmaInitialized = 1;
+    gpdma_Init();
+
+    mpDmaBounce = gpdma_Malloc(SPI1_DMA_BOUNCE_BYTES);
+    mpDmaFill = gpdma_Malloc(8);
+    if (0 != mpDmaBounce && 0 != mpDmaFill)
+    {
+        mpDmaFill[0] = 0xFF;
+
+        // Rx channel gets higher priority so the Rx FIFO never overflows
+        mDmaRxChannel = gpdma_AcquireChannel(1, spi1_DmaComplete, 0);
+        mDmaTxChannel = gpdma_AcquireChannel(1, 0, 0);
+    }
+}
 
 /**
- * TODO Use the DMA for SSP transfers.
- * This will decrease code size as many macros are used to do fast 256 byte transfers
+ * Transfers a chunk of data that fits in one DMA transfer
+ * @see spi1_DmaTransfer() for the parameters
  */
-#define USE_DMA     0
+static int spi1_DmaTransferChunk(const unsigned char* pTx, unsigned char* pRx, unsigned int len)
+{
+    const int useRxBounce = (0 != pRx && !gpdma_IsAccessible(pRx));
+    const unsigned int src = (0 == pTx) ? (unsigned int) &mpDmaFill[0] :
+                             gpdma_IsAccessible(pTx) ? (unsigned int) pTx : (unsigned int) mpDmaBounce;
+    const unsigned int dst = (0 == pRx) ? (unsigned int) &mpDmaFill[4] :
+                             useRxBounce ? (unsigned int) mpDmaBounce : (unsigned int) pRx;
+
+    /**
+     * Tx and Rx may share the bounce buffer because the Rx DMA writes a byte only after
+     * the Tx DMA has read the same byte from the buffer and sent it.
+     */
+    if (src == (unsigned int) mpDmaBounce) {
+        memcpy(mpDmaBounce, pTx, len);
+    }
 
-void spi1_SetMaxClockMhz(unsigned int maxClockMhz)
+    const unsigned int common = GPDMA_CTRL_SIZE(len) | GPDMA_CTRL_SRC_BURST(1) | GPDMA_CTRL_DST_BURST(1) |
+                                GPDMA_CTRL_SRC_WIDTH(0) | GPDMA_CTRL_DST_WIDTH(0);
+    const unsigned int txControl = common | ((0 == pTx) ? 0 : GPDMA_CTRL_SRC_INC);
+    const unsigned int rxControl = common | ((0 == pRx) ? 0 : GPDMA_CTRL_DST_INC) | GPDMA_CTRL_TC_INTR;
+
+    // Empty the Rx FIFO and clear the overrun so only the data of this transfer is received
+    while (LPC_SSP1->SR & (1 << 2)) {
+        (void) LPC_SSP1->DR;
+    }
+    LPC_SSP1->ICR = (1 << 0);
+
+    // Clear a stale notification, and let the DMA interrupt notify this task
+    const int waitForSignal = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    if (waitForSignal) {
+        ulTaskNotifyTake(pdTRUE, 0);
+        mDmaWaitingTask = xTaskGetCurrentTaskHandle();
+    }
+    mDmaError = 0;
+
+    // Start the Rx DMA before the Tx DMA so it is ready as soon as data arrives
+    LPC_SSP1->DMACR = (1 << 0) | (1 << 1);
+    gpdma_Start(mDmaRxChannel, (unsigned int) &(LPC_SSP1->DR), dst, 0, rxControl,
+                GPDMA_CFG_SRC_PERIPH(gpdma_ssp1Rx) | GPDMA_CFG_P2M);
+    gpdma_Start(mDmaTxChannel, src, (unsigned int) &(LPC_SSP1->DR), 0, txControl,
+                GPDMA_CFG_DST_PERIPH(gpdma_ssp1Tx) | GPDMA_CFG_M2P);
+
+    int success = 1;
+    if (waitForSignal) {
+        success = (0 != ulTaskNotifyTake(pdTRUE, SPI1_DMA_TIMEOUT_MS / portTICK_RATE_MS));
+        mDmaWaitingTask = 0;
+    }
+    else {
+        while (gpdma_IsBusy(mDmaRxChannel)) {
+            ;
+        }
+    }
+
+    if (!success || mDmaError) {
+        gpdma_Stop(mDmaTxChannel);
+        gpdma_Stop(mDmaRxChannel);
+        success = 0;
+    }
+    LPC_SSP1->DMACR = 0;
+
+    if (success && useRxBounce) {
+        memcpy(pRx, mpDmaBounce, len);
+    }
+    return success;
+}
+
+int spi1_DmaTransfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len)
 {
-    unsigned int divider = 2;
-    const unsigned int cpuClockMhz = getCpuClock() / (1000 * 1000UL);
+    // Short transfers or no DMA channels: use the FIFO directly
+    if (len < SPI1_DMA_MIN_BYTES || mDmaRxChannel < 0 || mDmaTxChannel < 0)
+    {
+        spi1_Transfer(pTx, pRx, len);
+        return 1;
+    }
+
+    // Data that needs the bounce buffer is transferred in chunks of the bounce buffer size
+    const int direct = (0 == pTx || gpdma_IsAccessible(pTx)) && (0 == pRx || gpdma_IsAccessible(pRx));
+    const unsigned int maxChunk = direct ? GPDMA_MAX_TRANSFER_SIZE : SPI1_DMA_BOUNCE_BYTES;
 
-    // Keep scaling down divider until calculated is higher
-    // Example:
-    // 60, need 18
-    // 60/2   18 < 30 YES
-    // 60/4   18 < 15 NO
-    while(maxClockMhz < (cpuClockMhz / divider) && divider <= 254)
+    while (len > 0)
     {
-        divider += 2;
+        const unsigned int chunk = (len > maxChunk) ? maxChunk : len;
+        if (!spi1_DmaTransferChunk(pTx, pRx, chunk)) {
+            return 0;
+        }
+
+        pTx = pTx ? (pTx + chunk) : 0;
+        pRx = pRx ? (pRx + chunk) : 0;
+        len -= chunk;
     }
+    return 1;
+}
+#endif /* SPI1_USE_DMA */
+
+
+
+static ssp_Bus mBus = { LPC_SSP1, 0, 0 };   ///< SPI bus mutex and its profile switches
+
+void spi1_SetMaxClockMhz(unsigned int maxClockMhz)
+{
+    ssp_SetMaxClockMhz(LPC_SSP1, maxClockMhz);
+}
+
+void spi1_SetBusMutex(xSemaphoreHandle mutex)
+{
+    mBus.mutex = mutex;
+}
+
+void spi1_ComputeDeviceProfile(spi1_Device* pDev, unsigned int maxClockKhz)
+{
+    ssp_ComputeDeviceProfile(pDev, maxClockKhz);
+}
+
+void spi1_SetDeviceClock(spi1_Device* pDev, unsigned int maxClockKhz)
+{
+    ssp_SetDeviceClock(LPC_SSP1, pDev, maxClockKhz);
+}
+
+void spi1_InitDevice(spi1_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                     LPC_GPIO_TypeDef* pCsPort, unsigned int csMask)
+{
+    ssp_InitDevice(LPC_SSP1, pDev, maxClockKhz, mode, pCsPort, csMask);
+}
 
-    LPC_SSP1->CPSR = divider;
+void spi1_Acquire(const spi1_Device* pDev)
+{
+    ssp_Acquire(&mBus, pDev);
+}
+
+void spi1_Release(void)
+{
+    ssp_Release(&mBus);
+}
+
+unsigned int spi1_GetProfileSwitches(void)
+{
+    return mBus.profileSwitches;
 }
 
 void spi1_Init()
@@ -38,169 +206,37 @@ void spi1_Init()
     LPC_SSP1->CR0 = 7;          // 8-bit mode
     LPC_SSP1->CR1 = (1 << 1);   // Enable SSP as Master
 
-#if USE_DMA
-    // Initialize DMA capability:
-    LPC_SSP1->DMACR = (1 << 0) | (1 << 1);
-
-    // Enable power to DMA:
-    LPC_SC->PCONP |= (1 << 29);
-    LPC_GPDMA->DMACConfig    |= (1 << 0); // GP-DMA Enable
+#if SPI1_USE_DMA
+    spi1_DmaInit();
 #endif
 
     spi1_SetMaxClockMhz(12);
 }
 
-#if USE_DMA
-void spi1_Receive256Bytes(unsigned char* pDest)
+void spi1_Transfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len)
 {
-    // Clear any pending interrupt and errors:
-    LPC_GPDMA->DMACIntErrClr = 0xFF;
-    LPC_GPDMA->DMACIntTCClear = 0xFF;
-
-    // Set source to SSP1 Data register and destination to the memory pointer
-    LPC_GPDMACH0->DMACCSrcAddr  = &(LPC_SSP1->DR);
-    LPC_GPDMACH0->DMACCDestAddr = pDest;
-
-    const unsigned short transferSize = (512 << 0);
-    const unsigned char srcBurstSize  = (0 << 12);
-    const unsigned char dstBurstSize  = (0 << 15);
-    const unsigned char srcWidthOneByte = (0 << 18);
-    const unsigned char dstWidthOneByte = (0 << 21);
-    const unsigned char srcDoNotIncrement = (0 << 26);
-    const unsigned char dstIncrement      = (1 << 27);
-
-    // Set linked list to NULL and configure the DMA transfer through CONTROL register
-    LPC_GPDMACH0->DMACCLLI = 0;
-    LPC_GPDMACH0->DMACCControl = (transferSize | srcBurstSize | dstBurstSize |
-                                    srcWidthOneByte | dstWidthOneByte |
-                                    srcDoNotIncrement | dstIncrement);
-
-    LPC_GPDMA->DMACEnbldChns |= (1 << 0); // Enable DMA Channel 0
-
-    // Enable the channel, set source peripheral to SSP1 RX, and transfer type to Peripheral to Memory
-    LPC_GPDMACH0->DMACCConfig = (1 << 0) | (3 << 1) |  (2 << 11);
+    ssp_Transfer(LPC_SSP1, pTx, pRx, len);
 }
 
-void spi1_Send256Bytes(unsigned char* pSrc)
+void spi1_Transfer16(const unsigned short* pTx, unsigned short* pRx, unsigned int count)
 {
+    ssp_Transfer16(LPC_SSP1, pTx, pRx, count);
 }
-#else
-
-/**
- * This macro waits until RX FIFO is half full (4 bytes)
- * then it reads 4 bytes and queues off 4 more bytes of transfer
- */
-#define spi1_Rx4BytesTx4Bytes(pByteArray)       \
-        while(! (LPC_SSP1->RIS & (1 << 2)));    \
-        *pByteArray++ = LPC_SSP1->DR;           \
-        LPC_SSP1->DR = 0xFF;                    \
-        *pByteArray++ = LPC_SSP1->DR;           \
-        LPC_SSP1->DR = 0xFF;                    \
-        *pByteArray++ = LPC_SSP1->DR;           \
-        LPC_SSP1->DR = 0xFF;                    \
-        *pByteArray++ = LPC_SSP1->DR;           \
-        LPC_SSP1->DR = 0xFF
-
-/**
- * This macro calls the macro above 4 times to do 16 byte transfers
- */
-#define spi1_Rx16BytesTx16Bytes(p256Bytes)      \
-        spi1_Rx4BytesTx4Bytes(p256Bytes);       \
-        spi1_Rx4BytesTx4Bytes(p256Bytes);       \
-        spi1_Rx4BytesTx4Bytes(p256Bytes);       \
-        spi1_Rx4BytesTx4Bytes(p256Bytes)
 
 void spi1_Receive256Bytes(unsigned char* p256Bytes)
 {
-    // Let the SSP roll with 8 byte initial transfer
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-    LPC_SSP1->DR = 0xFF;
-
-    // Now as soon as Rx FIFO shows half full, read 4 bytes and send 4 bytes through macros
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 16 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 32 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 48 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 64 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 80 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 96 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 112 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 128 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 144 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 160 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 176 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 192 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 208 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 224 Bytes
-    spi1_Rx16BytesTx16Bytes(p256Bytes); // 240 Bytes
-
-    spi1_Rx4BytesTx4Bytes(p256Bytes); /* Read 244 bytes */
-    spi1_Rx4BytesTx4Bytes(p256Bytes); /* Read 248 bytes */
-
-    /* SSP should have 8 bytes still pending at this point */
-    while(! (LPC_SSP1->RIS & (1 << 2)));
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-
-    while(! (LPC_SSP1->RIS & (1 << 2)));
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-    *p256Bytes++ = LPC_SSP1->DR;
-}
-
-#define spi1_send4Bytes(p256Bytes) \
-            while(! (LPC_SSP1->RIS & (1 << 3)));    \
-            LPC_SSP1->DR = *p256Bytes++;            \
-            LPC_SSP1->DR = *p256Bytes++;            \
-            LPC_SSP1->DR = *p256Bytes++;            \
-            LPC_SSP1->DR = *p256Bytes++
-#define spi1_send16Bytes(p256Bytes)         \
-            spi1_send4Bytes(p256Bytes);     \
-            spi1_send4Bytes(p256Bytes);     \
-            spi1_send4Bytes(p256Bytes);     \
-            spi1_send4Bytes(p256Bytes)
+#if SPI1_USE_DMA
+    spi1_DmaTransfer(0, p256Bytes, 256);
+#else
+    spi1_Transfer(0, p256Bytes, 256);
+#endif
+}
 
 void spi1_Send256Bytes(const unsigned char* p256Bytes)
 {
-    spi1_send16Bytes(p256Bytes); // 16 Bytes
-    spi1_send16Bytes(p256Bytes); // 32 Bytes
-    spi1_send16Bytes(p256Bytes); // 48 Bytes
-    spi1_send16Bytes(p256Bytes); // 64 Bytes
-    spi1_send16Bytes(p256Bytes); // 80 Bytes
-    spi1_send16Bytes(p256Bytes); // 96 Bytes
-    spi1_send16Bytes(p256Bytes); // 112 Bytes
-    spi1_send16Bytes(p256Bytes); // 128 Bytes
-
-    spi1_send16Bytes(p256Bytes); // 144 Bytes
-    spi1_send16Bytes(p256Bytes); // 160 Bytes
-    spi1_send16Bytes(p256Bytes); // 176 Bytes
-    spi1_send16Bytes(p256Bytes); // 192 Bytes
-    spi1_send16Bytes(p256Bytes); // 208 Bytes
-    spi1_send16Bytes(p256Bytes); // 224 Bytes
-    spi1_send16Bytes(p256Bytes); // 240 Bytes
-    spi1_send16Bytes(p256Bytes); // 256 Bytes
-
-    /* Wait for SSP to finish */
-    while(LPC_SSP1->SR & (1 << 4));
-
-    /* Important: Empty FIFO otherwise Rx FIFO will show full */
-    char dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-
-    dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-    dummy = LPC_SSP1->DR;
-}
-#endif /* If not using DMA */
-
+#if SPI1_USE_DMA
+    spi1_DmaTransfer(p256Bytes, 0, 256);
+#else
+    spi1_Transfer(p256Bytes, 0, 256);
+#endif
+}
@@ -0,0 +1,140 @@
+#include "ssp.h"
+#include "sysConfig.h"  // getCpuClock()
+#include "task.h"       // xTaskGetSchedulerState()
+
+
+
+void ssp_SetMaxClockMhz(LPC_SSP_TypeDef* pSsp, unsigned int maxClockMhz)
+{
+    unsigned int divider = 2;
+    const unsigned int cpuClockMhz = getCpuClock() / (1000 * 1000UL);
+
+    // Keep scaling down divider until calculated is higher
+    // Example:
+    // 60, need 18
+    // 60/2   18 < 30 YES
+    // 60/4   18 < 15 NO
+    while(maxClockMhz < (cpuClockMhz / divider) && divider <= 254)
+    {
+        divider += 2;
+    }
+
+    pSsp->CPSR = divider;
+}
+
+void ssp_ComputeDeviceProfile(ssp_Device* pDev, unsigned int maxClockKhz)
+{
+    // SSP PCLK is the CPU clock (see spi1_Init() and ssp0_Init())
+    const unsigned int pclkKhz = getCpuClock() / 1000;
+    if (0 == maxClockKhz) {
+        maxClockKhz = 1;
+    }
+
+    /**
+     * SCK = PCLK / (CPSR * (SCR+1)) where CPSR is even from 2-254 and SCR is 0-255.
+     * Find the smallest divider that doesn't exceed the max clock, and then use
+     * the smallest CPSR that can reach it because that gives the finest steps.
+     */
+    const unsigned int divider = (pclkKhz + maxClockKhz - 1) / maxClockKhz;
+    unsigned int cpsr = 2;
+    while ((divider + cpsr - 1) / cpsr > 256 && cpsr < 254) {
+        cpsr += 2;
+    }
+    unsigned int scr = (divider + cpsr - 1) / cpsr;
+    scr = (scr > 256) ? 255 : (scr > 0) ? (scr - 1) : 0;
+
+    pDev->cpsr = cpsr;
+    pDev->cr0 = 7 | (((pDev->mode >> 1) & 1) << 6) | ((pDev->mode & 1) << 7) | (scr << 8);
+}
+
+void ssp_SetDeviceClock(LPC_SSP_TypeDef* pSsp, ssp_Device* pDev, unsigned int maxClockKhz)
+{
+    const int inUse = (pSsp->CR0 == pDev->cr0 && pSsp->CPSR == pDev->cpsr);
+    ssp_ComputeDeviceProfile(pDev, maxClockKhz);
+
+    if (inUse) {
+        pSsp->CR0 = pDev->cr0;
+        pSsp->CPSR = pDev->cpsr;
+    }
+}
+
+void ssp_InitDevice(LPC_SSP_TypeDef* pSsp, ssp_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                    LPC_GPIO_TypeDef* pCsPort, unsigned int csMask)
+{
+    pDev->cr0 = 0;
+    pDev->cpsr = 0;
+    pDev->mode = mode & 3;
+    pDev->pCsPort = pCsPort;
+    pDev->csMask = csMask;
+    ssp_SetDeviceClock(pSsp, pDev, maxClockKhz);
+
+    pCsPort->FIOSET = csMask;
+    pCsPort->FIODIR |= csMask;
+}
+
+void ssp_Acquire(ssp_Bus* pBus, const ssp_Device* pDev)
+{
+    LPC_SSP_TypeDef* pSsp = pBus->pSsp;
+    if (0 != pBus->mutex && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        xSemaphoreTake(pBus->mutex, portMAX_DELAY);
+    }
+
+    // Only re-configure the SSP if the previous device used a different profile
+    if (pSsp->CR0 != pDev->cr0 || pSsp->CPSR != pDev->cpsr)
+    {
+        // SSP is disabled while the clock polarity and phase change
+        pSsp->CR1 &= ~(1 << 1);
+        pSsp->CR0 = pDev->cr0;
+        pSsp->CPSR = pDev->cpsr;
+        pSsp->CR1 |= (1 << 1);
+        ++(pBus->profileSwitches);
+    }
+}
+
+void ssp_Release(ssp_Bus* pBus)
+{
+    if (0 != pBus->mutex && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        xSemaphoreGive(pBus->mutex);
+    }
+}
+
+/**
+ * Transfers data keeping up to 8 frames in flight, which is the depth of the SSP FIFOs.
+ * Frames are written while the Tx FIFO is not full, and received frames are read as soon
+ * as they arrive, so the Rx FIFO never overflows and SSP never waits for the CPU.
+ */
+#define ssp_FifoTransfer(pSsp, type, pTx, pRx, len)                                 \
+        unsigned int txLeft = len;                                                  \
+        unsigned int rxLeft = len;                                                  \
+        while (pSsp->SR & (1 << 2)) {           /* Discard stale Rx data */         \
+            (void) pSsp->DR;                                                        \
+        }                                                                           \
+        while (rxLeft > 0)                                                          \
+        {                                                                           \
+            while (txLeft > 0 && (rxLeft - txLeft) < 8 && (pSsp->SR & (1 << 1))) {  \
+                pSsp->DR = pTx ? *pTx++ : (type) 0xFFFF;                            \
+                txLeft--;                                                           \
+            }                                                                       \
+            while (rxLeft > 0 && (pSsp->SR & (1 << 2))) {                           \
+                const type in = pSsp->DR;                                           \
+                if (pRx) {                                                          \
+                    *pRx++ = in;                                                    \
+                }                                                                   \
+                rxLeft--;                                                           \
+            }                                                                       \
+        }
+
+void ssp_Transfer(LPC_SSP_TypeDef* pSsp, const unsigned char* pTx, unsigned char* pRx, unsigned int len)
+{
+    ssp_FifoTransfer(pSsp, unsigned char, pTx, pRx, len);
+}
+
+void ssp_Transfer16(LPC_SSP_TypeDef* pSsp, const unsigned short* pTx, unsigned short* pRx, unsigned int count)
+{
+    const unsigned int cr0 = pSsp->CR0;
+    pSsp->CR0 = (cr0 & ~0xF) | 15;      // 16-bit frames
+
+    ssp_FifoTransfer(pSsp, unsigned short, pTx, pRx, count);
+
+    pSsp->CR0 = cr0;
+}
@@ -0,0 +1,78 @@
+#include "ssp0.h"
+#include "sysConfig.h"
+
+
+
+static ssp_Bus mBus = { LPC_SSP0, 0, 0 };   ///< SSP0 bus mutex and its profile switches
+
+void ssp0_SetBusMutex(xSemaphoreHandle mutex)
+{
+    mBus.mutex = mutex;
+}
+
+void ssp0_SetDeviceClock(ssp0_Device* pDev, unsigned int maxClockKhz)
+{
+    ssp_SetDeviceClock(LPC_SSP0, pDev, maxClockKhz);
+}
+
+void ssp0_InitDevice(ssp0_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                     LPC_GPIO_TypeDef* pCsPort, unsigned int csMask)
+{
+    ssp_InitDevice(LPC_SSP0, pDev, maxClockKhz, mode, pCsPort, csMask);
+}
+
+void ssp0_Acquire(const ssp0_Device* pDev)
+{
+    ssp_Acquire(&mBus, pDev);
+}
+
+void ssp0_Release(void)
+{
+    ssp_Release(&mBus);
+}
+
+unsigned int ssp0_GetProfileSwitches(void)
+{
+    return mBus.profileSwitches;
+}
+
+void ssp0_SetMaxClockMhz(unsigned int maxClockMhz)
+{
+    ssp_SetMaxClockMhz(LPC_SSP0, maxClockMhz);
+}
+
+void ssp0_Init()
+{
+    LPC_SC->PCONP |= (1 << 21);     // SSP0 Power Enable
+    LPC_SC->PCLKSEL1 &= ~(3 << 10); // Clear clock Bits
+    LPC_SC->PCLKSEL1 |=  (1 << 10); // CLK / 1
+
+    // Select SCK0, MISO0, MOSI0 at P1.20, P1.23 and P1.24
+    LPC_PINCON->PINSEL3 &= ~( (3 << 8) | (3 << 14) | (3 << 16) );
+    LPC_PINCON->PINSEL3 |=  ( (3 << 8) | (3 << 14) | (3 << 16) );
+
+    LPC_SSP0->CR0 = 7;          // 8-bit mode
+    LPC_SSP0->CR1 = (1 << 1);   // Enable SSP as Master
+
+    ssp0_SetMaxClockMhz(12);
+}
+
+void ssp0_Transfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len)
+{
+    ssp_Transfer(LPC_SSP0, pTx, pRx, len);
+}
+
+void ssp0_Transfer16(const unsigned short* pTx, unsigned short* pRx, unsigned int count)
+{
+    ssp_Transfer16(LPC_SSP0, pTx, pRx, count);
+}
+
+void ssp0_Receive256Bytes(unsigned char* p256Bytes)
+{
+    ssp0_Transfer(0, p256Bytes, 256);
+}
+
+void ssp0_Send256Bytes(const unsigned char* p256Bytes)
+{
+    ssp0_Transfer(p256Bytes, 0, 256);
+}
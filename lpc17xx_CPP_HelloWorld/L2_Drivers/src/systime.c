@@ -0,0 +1,150 @@
+#include "systime.h"
+#include "LPC17xx.h"
+#include "sysConfig.h"  // TIMER0_US_PER_TICK, INTR_PRIORITY_SYSTIME
+
+
+
+static volatile unsigned int mTimerWraps = 0;       ///< Number of times Timer0 TC has overflowed
+static RTC mWallTime;                               ///< The RTC time at the start of the current second
+static unsigned int mFatTime = 0;                   ///< mWallTime in the FAT file system format
+static unsigned long long mSecondStartMicros = 0;   ///< The microsecond time when the current second started
+static char mInitialized = 0;                       ///< Set once systime_Init() is called
+
+/// Reads the consolidated RTC registers, reading again if a second elapsed in between
+static RTC systime_ReadRtc(void)
+{
+    RTC time = rtc_gettime();
+    RTC again = rtc_gettime();
+    while (time.sec != again.sec) {
+        time = again;
+        again = rtc_gettime();
+    }
+    return time;
+}
+
+/// Converts the RTC time to the FAT file system format
+static unsigned int systime_ToFatTime(const RTC* pTime)
+{
+    return ((unsigned int) (pTime->year - 1980) << 25)
+            | ((unsigned int) pTime->month << 21)
+            | ((unsigned int) pTime->day << 16)
+            | ((unsigned int) pTime->hour << 11)
+            | ((unsigned int) pTime->min << 5)
+            | ((unsigned int) pTime->sec >> 1);
+}
+
+/// Updates the cached wall-clock time from the RTC
+static void systime_SyncRtc(void)
+{
+    const RTC time = systime_ReadRtc();
+    const unsigned long long now = systime_GetMicros();
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        mWallTime = time;
+        mFatTime = systime_ToFatTime(&time);
+        mSecondStartMicros = now;
+    }
+    __set_PRIMASK(primask);
+}
+
+/// Timer0 match 0 occurs when TC overflows to zero
+void TIMER0_IRQHandler(void)
+{
+    // Timer0 also wakes up the CPU from tickless idle (port.c), which clears its own match flag
+    if (LPC_TIM0->IR & (1 << 0)) {
+        LPC_TIM0->IR = (1 << 0);
+        ++mTimerWraps;
+    }
+}
+
+/// RTC interrupt at the start of each second
+void RTC_IRQHandler(void)
+{
+    LPC_RTC->ILR = (1 << 0) | (1 << 1);  // Clear counter increment and alarm interrupts
+    systime_SyncRtc();
+}
+
+void systime_Init(void)
+{
+    LPC_TIM0->MR0 = 0;
+    LPC_TIM0->IR = (1 << 0);
+    LPC_TIM0->MCR |= (1 << 0);      // Interrupt on MR0
+    NVIC_SetPriority(TIMER0_IRQn, INTR_PRIORITY_SYSTIME);
+    NVIC_EnableIRQ(TIMER0_IRQn);
+
+    systime_SyncRtc();
+    mInitialized = 1;
+
+    LPC_RTC->ILR = (1 << 0) | (1 << 1);
+    LPC_RTC->CIIR = (1 << 0);       // Interrupt when seconds increment
+    NVIC_SetPriority(RTC_IRQn, INTR_PRIORITY_SYSTIME);
+    NVIC_EnableIRQ(RTC_IRQn);
+}
+
+unsigned long long systime_GetMicros(void)
+{
+    unsigned int tc = 0;
+    unsigned int pc = 0;
+    unsigned int wraps = 0;
+
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        // Read again if TC incremented while reading PC
+        do {
+            tc = LPC_TIM0->TC;
+            pc = LPC_TIM0->PC;
+        } while (tc != LPC_TIM0->TC);
+
+        // TC overflowed, but the interrupt didn't run yet because we are in an ISR or critical section
+        wraps = mTimerWraps;
+        if ((LPC_TIM0->IR & (1 << 0)) && tc < 0x80000000) {
+            ++wraps;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    const unsigned long long ticks = ((unsigned long long) wraps << 32) | tc;
+    return (ticks * TIMER0_US_PER_TICK) + ((pc * TIMER0_US_PER_TICK) / (LPC_TIM0->PR + 1));
+}
+
+unsigned int systime_GetMillis(void)
+{
+    return (unsigned int) (systime_GetMicros() / 1000);
+}
+
+unsigned int systime_GetWallTime(RTC* pTime)
+{
+    if (!mInitialized) {
+        systime_SyncRtc();
+    }
+
+    unsigned long long secondStart = 0;
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        *pTime = mWallTime;
+        secondStart = mSecondStartMicros;
+    }
+    __set_PRIMASK(primask);
+
+    // Limit to a second in case the RTC interrupt is late
+    const unsigned long long elapsed = systime_GetMicros() - secondStart;
+    return (elapsed < 1000000) ? (unsigned int) elapsed : 999999;
+}
+
+void systime_SetWallTime(const RTC* pTime)
+{
+    rtc_settime(pTime);
+    systime_SyncRtc();
+}
+
+unsigned int systime_GetFatTime(void)
+{
+    if (!mInitialized) {
+        systime_SyncRtc();
+    }
+    return mFatTime;
+}
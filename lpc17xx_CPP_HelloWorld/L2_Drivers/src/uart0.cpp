@@ -1,5 +1,6 @@
 #include "uart0.hpp"
 #include "LPC17xx.h"    // LPC_UART0_BASE
+#include "profiler.hpp" // PROFILE_SCOPE()
 #include "sysConfig.h"  // getSystemClock()
 
 
@@ -13,6 +14,7 @@ extern "C"
 {
     void UART0_IRQHandler()
     {
+        PROFILE_SCOPE("uart0 isr");
         UART0::getInstance().handleInterrupt();
     }
 }
@@ -28,8 +30,12 @@ char UART0::putcharIntrDriven(char theChar)
 {
     return UART0::getInstance().putChar(theChar);
 }
+int UART0::writeIntrDriven(const char* pData, int len)
+{
+    return UART0::getInstance().write(pData, len);
+}
 
-bool UART0::init(unsigned int baudRate, int rxQSize, int txQSize)
+bool UART0::init(unsigned int baudRate, int rxQSize, int txQSize, bool useDma)
 {
     // Configure PINSEL for UART0
     LPC_PINCON->PINSEL0 &= ~(0xF << 4); // Clear values
@@ -39,7 +45,7 @@ bool UART0::init(unsigned int baudRate, int rxQSize, int txQSize)
     LPC_SC->PCLKSEL0 &= ~(3 << 6);
     const unsigned int pclk = getCpuClock() / 4;
 
-    return UART_Base::init(pclk, baudRate, rxQSize, txQSize);
+    return UART_Base::init(pclk, baudRate, rxQSize, txQSize, useDma);
 }
 
 UART0::UART0() : UART_Base((unsigned int*)LPC_UART0_BASE)
@@ -1,31 +1,97 @@
 #include "UART_Base.hpp"
 #include "LPC17xx.h"
+#include "sysConfig.h"  // INTR_PRIORITY_UART
+#include "task.h"       // xTaskGetSchedulerState()
+#include "filelogger.hpp"   // LOG_ERROR_FROM_ISR()
 
 bool UART_Base::getChar(char* pInputChar, unsigned int timeout)
 {
-    return xQueueReceive(mRxQueue, pInputChar, timeout);
+    return (1 == read(pInputChar, 1, timeout));
 }
 
 bool UART_Base::putChar(char out, unsigned int timeout)
 {
-    // If queue is full even after the timeout, return with error
-    if (!xQueueSend(mTxQueue, &out, timeout))
+    return (1 == write(&out, 1, timeout));
+}
+
+int UART_Base::write(const char* pData, int len, unsigned int timeout)
+{
+    int bytesWritten = 0;
+
+    /**
+     * The transmit buffer only supports one producer, so tasks take turns to write to it.
+     * Before the scheduler starts, there is only one writer, and an ISR cannot block.
+     */
+    const bool useMutex = (0 != mTxMutex)
+                          && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+                          && (0 == (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk));
+    if (useMutex && !xSemaphoreTake(mTxMutex, timeout))
     {
-        return false;
+        return 0;
     }
 
-    portENTER_CRITICAL();
+    while (bytesWritten < len)
     {
-        long unUsed = 0;
-        if (!mIntrExpected && xQueueReceiveFromISR(mTxQueue, &out, &unUsed))
+        bytesWritten += mTxBuffer.write(pData + bytesWritten, len - bytesWritten);
+        kickTransmitter();
+
+        /**
+         * Block only if the transmit buffer is full and we still have data to write.
+         * ISR will give the signal once it moves data to hardware FIFO
+         */
+        if (bytesWritten < len && !xSemaphoreTake(mTxSignal, timeout))
         {
-            mIntrExpected = true;
-            mpUARTRegBase->THR = out;
+            break;
         }
     }
-    portEXIT_CRITICAL();
 
-    return true;
+    if (useMutex)
+    {
+        xSemaphoreGive(mTxMutex);
+    }
+
+    return bytesWritten;
+}
+
+int UART_Base::read(char* pData, int len, unsigned int timeout)
+{
+    /**
+     * In DMA mode, we may not get the receive interrupt after DMA empties the
+     * FIFO, so we need to check the DMA position periodically while waiting.
+     */
+    const unsigned int dmaPollTicks = OS_MS(10);
+    int bytesRead = 0;
+
+    while (bytesRead < len)
+    {
+        if (mUseDma)
+        {
+            portENTER_CRITICAL();
+            updateRxFromDma();
+            portEXIT_CRITICAL();
+        }
+
+        bytesRead += mRxBuffer.read(pData + bytesRead, len - bytesRead);
+
+        // Block only if the receive buffer is empty and we need more data
+        if (bytesRead < len)
+        {
+            const unsigned int wait = (mUseDma && timeout > dmaPollTicks) ? dmaPollTicks : timeout;
+            if (!xSemaphoreTake(mRxSignal, wait))
+            {
+                if (wait == timeout)
+                {
+                    break;
+                }
+                if (portMAX_DELAY != timeout)
+                {
+                    timeout -= wait;
+                }
+            }
+        }
+    }
+
+    return bytesRead;
 }
 
 void UART_Base::handleInterrupt()
@@ -50,21 +116,27 @@ void UART_Base::handleInterrupt()
     {
         case transmitterEmpty:
         {
+            if (mUseDma)
+            {
+                break;
+            }
+
             mIntrExpected = false;
             /**
              * When THRE (Transmit Holding Register Empty) interrupt occurs,
              * we can send as many bytes as the hardware FIFO supports (16)
              */
             const unsigned char hwTxFifoSize = 16;
-            for(unsigned char i=0;
-                    i < hwTxFifoSize && !xQueueIsQueueEmptyFromISR(mTxQueue);
-                    i++)
+            for (unsigned char i = 0; i < hwTxFifoSize && mTxBuffer.get(&c); i++)
             {
-                if (xQueueReceiveFromISR(mTxQueue, &c, &higherPriorityTaskWoken))
-                {
-                    mIntrExpected = true;
-                    mpUARTRegBase->THR = c;
-                }
+                mIntrExpected = true;
+                mpUARTRegBase->THR = c;
+            }
+
+            // Let the writer know that there is more space in the transmit buffer
+            if (mIntrExpected)
+            {
+                xSemaphoreGiveFromISR(mTxSignal, &higherPriorityTaskWoken);
             }
             break;
         }
@@ -72,15 +144,37 @@ void UART_Base::handleInterrupt()
         case dataAvailable:
         case dataTimeout:
         {
+            // In DMA mode, data is already being moved to our buffer by the DMA
+            if (mUseDma)
+            {
+                updateRxFromDma();
+                xSemaphoreGiveFromISR(mRxSignal, &higherPriorityTaskWoken);
+                break;
+            }
+
             /**
-             * While receive Hardware FIFO not empty, keep queuing the data.
-             * Even if xQueueSendFromISR() Fails (Queue is full), we still need to
-             * read RBR register otherwise interrupt will not clear
+             * While receive Hardware FIFO not empty, keep buffering the data.
+             * Even if the receive buffer is full, we still need to read RBR
+             * register otherwise interrupt will not clear
              */
-            while (0 != (mpUARTRegBase->LSR & (1 << 0)))
+            unsigned int lineStatus = 0;
+            unsigned int bytesLost = 0;
+            bool overrun = false;
+            while (0 != ((lineStatus = mpUARTRegBase->LSR) & (1 << 0)))
             {
+                overrun |= (0 != (lineStatus & (1 << 1)));
                 c = mpUARTRegBase->RBR;
-                xQueueSendFromISR(mRxQueue, &c, &higherPriorityTaskWoken);
+                if (!mRxBuffer.put(c)) {
+                    ++bytesLost;
+                }
+            }
+            xSemaphoreGiveFromISR(mRxSignal, &higherPriorityTaskWoken);
+
+            if (overrun) {
+                LOG_ERROR_FROM_ISR("UART Rx FIFO overrun");
+            }
+            if (bytesLost) {
+                LOG_WARN_FROM_ISR("UART Rx buffer full, %u bytes lost", bytesLost);
             }
             break;
         }
@@ -100,36 +194,46 @@ void UART_Base::handleInterrupt()
 ///////////////
 UART_Base::UART_Base(unsigned int* pUARTBaseAddr) :
         mpUARTRegBase((LPC_UART_TypeDef*) pUARTBaseAddr),
-        mIntrExpected(false)
+        mRxSignal(0),
+        mTxSignal(0),
+        mTxMutex(0),
+        mIntrExpected(false),
+        mUseDma(false),
+        mTxDmaChannel(-1),
+        mRxDmaChannel(-1),
+        mTxDmaBytes(0),
+        mTxDmaRequest(0)
 {
 
 }
 
 bool UART_Base::init(unsigned int pclk, unsigned int baudRate,
-                        int rxQSize, int txQSize)
+                        int rxQSize, int txQSize, bool useDma)
 {
+    IRQn_Type uartIrq;
+
     // Configure UART Hardware: Baud rate, FIFOs etc.
     if (LPC_UART0_BASE == (unsigned int) mpUARTRegBase)
     {
         LPC_SC->PCONP |= (1 << 3); // Enable UART0
-        NVIC_EnableIRQ(UART0_IRQn);
+        uartIrq = UART0_IRQn;
     }
     /*
      else if(LPC_UART1_BASE == (unsigned int)mpUARTRegBase)
      {
      LPC_SC->PCONP |= (1 << 4); // Enable UART1
-     NVIC_EnableIRQ(UART1_IRQn);
+     uartIrq = UART1_IRQn;
      }
      */
     else if (LPC_UART2_BASE == (unsigned int) mpUARTRegBase)
     {
         LPC_SC->PCONP |= (1 << 24); // Enable UART2
-        NVIC_EnableIRQ(UART2_IRQn);
+        uartIrq = UART2_IRQn;
     }
     else if (LPC_UART3_BASE == (unsigned int) mpUARTRegBase)
     {
         LPC_SC->PCONP |= (1 << 25); // Enable UART3
-        NVIC_EnableIRQ(UART3_IRQn);
+        uartIrq = UART3_IRQn;
     }
     else
     {
@@ -146,16 +250,163 @@ bool UART_Base::init(unsigned int pclk, unsigned int baudRate,
     }
     mpUARTRegBase->LCR = 3; // Disable DLAB and set 8bit per char
 
-    // Set minimum queue size
+    // Set minimum buffer size
     if (rxQSize < 9) rxQSize = 8;
     if (txQSize < 9) txQSize = 8;
 
-    // Create the receive and transmit queues
-    mRxQueue = xQueueCreate(rxQSize, sizeof(char));
-    mTxQueue = xQueueCreate(txQSize, sizeof(char));
+    // Create the receive and transmit buffers, and the signals used to block on them
+    mUseDma = useDma && initDma(rxQSize, txQSize);
+    const bool buffersReady = mUseDma || (mRxBuffer.init(rxQSize) && mTxBuffer.init(txQSize));
+    vSemaphoreCreateBinary(mRxSignal);
+    vSemaphoreCreateBinary(mTxSignal);
+    if (0 == mTxMutex)
+    {
+        mTxMutex = xSemaphoreCreateMutex();
+    }
+
+    // Priority needs to be low enough for the ISR to use FreeRTOS API
+    NVIC_SetPriority(uartIrq, INTR_PRIORITY_UART);
+    NVIC_EnableIRQ(uartIrq);
+
+    // Enable Rx/Tx Interrupts (THRE interrupt is not needed when DMA is transmitting)
+    mpUARTRegBase->IER = mUseDma ? (1 << 0) : (1 << 0) | (1 << 1); // B0:Rx, B1: Tx
+
+    return (buffersReady && 0 != mRxSignal && 0 != mTxSignal && 0 != mTxMutex);
+}
+
+void UART_Base::kickTransmitter()
+{
+    /**
+     * If the THRE (or DMA) interrupt is not expected, then the transmitter is idle
+     * and we need to start the transmission ourselves.  Otherwise the ISR will
+     * continue to send data from the transmit buffer.
+     */
+    portENTER_CRITICAL();
+    if (!mIntrExpected)
+    {
+        if (mUseDma)
+        {
+            startTxDma();
+        }
+        else
+        {
+            const unsigned char hwTxFifoSize = 16;
+            char c = 0;
+            for (unsigned char i = 0; i < hwTxFifoSize && mTxBuffer.get(&c); i++)
+            {
+                mIntrExpected = true;
+                mpUARTRegBase->THR = c;
+            }
+        }
+    }
+    portEXIT_CRITICAL();
+}
+
+bool UART_Base::initDma(int rxBufferSize, int txBufferSize)
+{
+    gpdma_Peripheral txRequest;
+    if (LPC_UART0_BASE == (unsigned int) mpUARTRegBase)      txRequest = gpdma_uart0Tx;
+    else if (LPC_UART2_BASE == (unsigned int) mpUARTRegBase) txRequest = gpdma_uart2Tx;
+    else if (LPC_UART3_BASE == (unsigned int) mpUARTRegBase) txRequest = gpdma_uart3Tx;
+    else return false;
+    const gpdma_Peripheral rxRequest = (gpdma_Peripheral) (txRequest + 1);
+
+    // Receive buffer is one DMA transfer that restarts itself, so it cannot be too large
+    if (rxBufferSize > GPDMA_MAX_TRANSFER_SIZE - 1) {
+        rxBufferSize = GPDMA_MAX_TRANSFER_SIZE - 1;
+    }
+
+    // Buffers and the linked list item need to be in the memory that DMA can access
+    char* pRxMem = (char*) gpdma_Malloc(rxBufferSize + 1);
+    char* pTxMem = (char*) gpdma_Malloc(txBufferSize + 1);
+    gpdma_Lli* pRxLli = (gpdma_Lli*) gpdma_Malloc(sizeof(gpdma_Lli));
+    if (0 == pRxMem || 0 == pTxMem || 0 == pRxLli) {
+        return false;
+    }
+
+    gpdma_Init();
+    if (mTxDmaChannel < 0) {
+        mTxDmaChannel = gpdma_AcquireChannel(false, dmaTxComplete, this);
+    }
+    if (mRxDmaChannel < 0) {
+        // Receive channel is given higher priority to avoid overrun of UART Rx FIFO
+        mRxDmaChannel = gpdma_AcquireChannel(true, 0, 0);
+    }
+    if (mTxDmaChannel < 0 || mRxDmaChannel < 0) {
+        return false;
+    }
 
-    // Enable Rx/Tx Interrupts:
-    mpUARTRegBase->IER = (1 << 0) | (1 << 1); // B0:Rx, B1: Tx
+    mRxBuffer.init(pRxMem, rxBufferSize + 1);
+    mTxBuffer.init(pTxMem, txBufferSize + 1);
 
-    return (0 != mRxQueue && 0 != mTxQueue);
+    // Select UART instead of Timer match for the DMA requests
+    LPC_SC->DMAREQSEL &= ~((1 << (txRequest - 8)) | (1 << (rxRequest - 8)));
+
+    // Enable & Reset FIFOs, enable DMA mode and set 8 char Rx trigger level
+    mpUARTRegBase->FCR = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (2 << 6);
+
+    /**
+     * Receive DMA writes to the entire buffer memory, and then the linked list
+     * item pointing to itself restarts it from the beginning of the buffer.
+     * The DMA does 8 byte bursts on the trigger level, and single byte transfers
+     * upon the character timeout.
+     */
+    const unsigned int rxControl = GPDMA_CTRL_SIZE(mRxBuffer.getMemorySize()) |
+                                   GPDMA_CTRL_SRC_BURST(2) | GPDMA_CTRL_DST_BURST(2) |
+                                   GPDMA_CTRL_SRC_WIDTH(0) | GPDMA_CTRL_DST_WIDTH(0) |
+                                   GPDMA_CTRL_DST_INC;
+    pRxLli->src = (unsigned int) &(mpUARTRegBase->RBR);
+    pRxLli->dst = (unsigned int) pRxMem;
+    pRxLli->pNext = pRxLli;
+    pRxLli->control = rxControl;
+
+    gpdma_Start(mRxDmaChannel, pRxLli->src, pRxLli->dst, pRxLli, rxControl,
+                GPDMA_CFG_SRC_PERIPH(rxRequest) | GPDMA_CFG_P2M);
+
+    // Transmit DMA is started by startTxDma() when we have data to send
+    mTxDmaRequest = txRequest;
+    mIntrExpected = false;
+
+    return true;
+}
+
+void UART_Base::startTxDma()
+{
+    const char* pData = 0;
+    unsigned int len = mTxBuffer.getContiguousData(&pData);
+    if (len > GPDMA_MAX_TRANSFER_SIZE) {
+        len = GPDMA_MAX_TRANSFER_SIZE;
+    }
+
+    mIntrExpected = (len > 0);
+    if (mIntrExpected)
+    {
+        mTxDmaBytes = len;
+        gpdma_Start(mTxDmaChannel, (unsigned int) pData, (unsigned int) &(mpUARTRegBase->THR), 0,
+                    GPDMA_CTRL_SIZE(len) | GPDMA_CTRL_SRC_WIDTH(0) | GPDMA_CTRL_DST_WIDTH(0) |
+                    GPDMA_CTRL_SRC_INC | GPDMA_CTRL_TC_INTR,
+                    GPDMA_CFG_DST_PERIPH(mTxDmaRequest) | GPDMA_CFG_M2P);
+    }
+}
+
+void UART_Base::updateRxFromDma()
+{
+    const unsigned int dmaAddr = gpdma_GetChannel(mRxDmaChannel)->DMACCDestAddr;
+    mRxBuffer.setWriteIndex(dmaAddr - (unsigned int) mRxBuffer.getMemory());
+}
+
+void UART_Base::dmaTxComplete(void* pThisUart, int error)
+{
+    UART_Base* pUart = (UART_Base*) pThisUart;
+    long higherPriorityTaskWoken = 0;
+
+    // Even upon error, discard the data otherwise we will keep retrying the same data
+    pUart->mTxBuffer.consume(pUart->mTxDmaBytes);
+    pUart->startTxDma();
+
+    xSemaphoreGiveFromISR(pUart->mTxSignal, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken)
+    {
+        vPortYieldFromISR();
+    }
 }
@@ -0,0 +1,90 @@
+/**
+ * @file    ssp.h
+ * @brief   Functions shared by the SSP drivers (spi1 and ssp0)
+ * @ingroup Drivers
+ *
+ * Both SSP peripherals have the same registers, so the device profiles, the bus
+ * arbitration and the FIFO transfers are implemented once here for any SSP.  The
+ * spi1_* and ssp0_* functions are thin wrappers that pass their own SSP and bus.
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef SSP_H_
+#define SSP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "LPC17xx.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+/**
+ * The profile of a device on an SSP bus.  The SSP register values are computed
+ * once by ssp_InitDevice() so acquiring the bus only needs to compare and copy them.
+ */
+typedef struct {
+    unsigned short cr0;         ///< SSP CR0 value: 8-bit frames, SPI mode and SCR
+    unsigned char cpsr;         ///< SSP CPSR value: even clock prescaler
+    unsigned char mode;         ///< SPI mode 0-3 (CPOL = bit 1, CPHA = bit 0)
+    LPC_GPIO_TypeDef* pCsPort;  ///< GPIO port of the active low chip-select signal
+    unsigned int csMask;        ///< GPIO bit-mask of the chip-select signal
+} ssp_Device;
+
+/**
+ * The state of an SSP bus shared by its devices.
+ * Initialize with the SSP, such as: static ssp_Bus gBus = { LPC_SSP1, 0, 0 };
+ */
+typedef struct {
+    LPC_SSP_TypeDef* pSsp;          ///< The SSP peripheral of this bus
+    xSemaphoreHandle mutex;         ///< Mutex that gives one device at a time the bus, or NULL
+    unsigned int profileSwitches;   ///< Number of times the SSP was configured for another device
+} ssp_Bus;
+
+
+
+/**
+ * Sets the SSP clock prescaler for the maximum clock in Megahertz.
+ * @note The speed may be set lower to maxClockMhz if it cannot be attained.
+ */
+void ssp_SetMaxClockMhz(LPC_SSP_TypeDef* pSsp, unsigned int maxClockMhz);
+
+/**
+ * Computes the SSP register values of a device profile without applying them.
+ * Both SSPs run at PCLK equal to the CPU clock, so the profile is valid for either SSP.
+ */
+void ssp_ComputeDeviceProfile(ssp_Device* pDev, unsigned int maxClockKhz);
+
+/**
+ * Changes the clock of a device profile.
+ * If the device is using the SSP, the new clock is applied right away.
+ */
+void ssp_SetDeviceClock(LPC_SSP_TypeDef* pSsp, ssp_Device* pDev, unsigned int maxClockKhz);
+
+/// Initializes a device profile, and sets its chip-select as an output (de-selected)
+void ssp_InitDevice(LPC_SSP_TypeDef* pSsp, ssp_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                    LPC_GPIO_TypeDef* pCsPort, unsigned int csMask);
+
+/**
+ * Acquires the bus for a device, and configures the SSP with the device's profile
+ * if the profile differs from the one used by the previous owner of the bus.
+ * The mutex is only used once FreeRTOS is running.
+ */
+void ssp_Acquire(ssp_Bus* pBus, const ssp_Device* pDev);
+
+/// Releases the bus acquired by ssp_Acquire()
+void ssp_Release(ssp_Bus* pBus);
+
+/// Transfers a block of bytes using the SSP FIFO @see spi1_Transfer()
+void ssp_Transfer(LPC_SSP_TypeDef* pSsp, const unsigned char* pTx, unsigned char* pRx, unsigned int len);
+
+/// Transfers a block of 16-bit values using the SSP FIFO @see spi1_Transfer16()
+void ssp_Transfer16(LPC_SSP_TypeDef* pSsp, const unsigned short* pTx, unsigned short* pRx, unsigned int count);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SSP_H_ */
@@ -0,0 +1,99 @@
+/**
+ * @file    ssp0.h
+ * @brief   SSP0 driver with the same API as the spi1 driver
+ * @ingroup Drivers
+ *
+ * SSP0 is a second SPI bus with its own mutex, so a device on SSP0 (such as the LCD)
+ * can transfer data at the same time as the SD Card and Flash Memory use SPI1.
+ *
+ * SSP0 uses these pins because P0.15 and P0.16 are used as chip-selects:
+ *  - SCK0  : P1.20
+ *  - MISO0 : P1.23
+ *  - MOSI0 : P1.24
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef SSP0_H_
+#define SSP0_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "ssp.h"    // ssp_Device and the functions shared with spi1
+
+
+
+/// SSP0 device profile, which is the same as the SPI1 device profile
+typedef ssp_Device ssp0_Device;
+
+
+
+/**
+ * Sets SSP0 Clock speed
+ * @param maxClockMhz   The maximum speed of this SPI in Megahertz
+ * @note The speed may be set lower to maxClockMhz if it cannot be attained.
+ */
+void ssp0_SetMaxClockMhz(unsigned int maxClockMhz);
+
+/**
+ * Initializes SSP0
+ * Configures CLK, MISO, MOSI pins with a slow SCK speed
+ */
+void ssp0_Init();
+
+/**
+ * Exchanges a byte over SSP0
+ * @param out   The byte to send out
+ * @returns     The byte received over SPI
+ */
+inline char ssp0_ExchangeByte(char out)
+{
+    LPC_SSP0->DR = out;
+    while(LPC_SSP0->SR & (1 << 4)); // Wait until SSP is busy
+    return LPC_SSP0->DR;
+}
+
+/// @see spi1_Transfer()
+void ssp0_Transfer(const unsigned char* pTx, unsigned char* pRx, unsigned int len);
+
+/// @see spi1_Transfer16()
+void ssp0_Transfer16(const unsigned short* pTx, unsigned short* pRx, unsigned int count);
+
+/// Receives 256 bytes and saves it to @param p256Bytes
+void ssp0_Receive256Bytes(unsigned char* p256Bytes);
+
+/// Sends a block of 256 bytes pointed by @param p256Bytes
+void ssp0_Send256Bytes(const unsigned char* p256Bytes);
+
+
+
+/// @see spi1_SetBusMutex()
+void ssp0_SetBusMutex(xSemaphoreHandle mutex);
+
+/// @see spi1_InitDevice()
+void ssp0_InitDevice(ssp0_Device* pDev, unsigned int maxClockKhz, unsigned char mode,
+                     LPC_GPIO_TypeDef* pCsPort, unsigned int csMask);
+
+/// @see spi1_SetDeviceClock()
+void ssp0_SetDeviceClock(ssp0_Device* pDev, unsigned int maxClockKhz);
+
+/// @see spi1_Acquire()
+void ssp0_Acquire(const ssp0_Device* pDev);
+
+/// Releases the SSP0 bus acquired by ssp0_Acquire()
+void ssp0_Release(void);
+
+/// @returns the number of times SSP0 was re-configured for a different device profile
+unsigned int ssp0_GetProfileSwitches(void);
+
+/// Selects the device by asserting its chip-select (the bus should be acquired)
+static inline void ssp0_Select(const ssp0_Device* pDev)   { pDev->pCsPort->FIOCLR = pDev->csMask; }
+
+/// De-selects the device by de-asserting its chip-select
+static inline void ssp0_Deselect(const ssp0_Device* pDev) { pDev->pCsPort->FIOSET = pDev->csMask; }
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SSP0_H_ */
@@ -0,0 +1,58 @@
+/**
+ * @file    systime.h
+ * @ingroup Drivers
+ * @brief   System time service that provides a monotonic 64-bit microsecond clock
+ *          based on Timer0, and the wall-clock time of the RTC.
+ *
+ * Timer0 (started by vConfigureTimerForRunTimeStats()) counts at TIMER0_US_PER_TICK and
+ * its prescale counter provides the microseconds within a tick.  A match interrupt at
+ * each Timer0 overflow extends it to 64-bits, so the clock never wraps.
+ *
+ * The RTC interrupts at each second, and the interrupt caches the RTC time, the FAT
+ * timestamp, and the microsecond time when the second started.  Reading the wall-clock
+ * time then only copies the cached values instead of reading the RTC registers.
+ *
+ * All functions except systime_Init() are safe to call from ISRs.
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef SYSTIME_H_
+#define SYSTIME_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "rtc.h"
+
+
+
+/**
+ * Initializes the time service.
+ * Timer0 and the RTC must be initialized before calling this function.
+ */
+void systime_Init(void);
+
+/// @returns the microseconds since Timer0 was started (monotonic, never wraps)
+unsigned long long systime_GetMicros(void);
+
+/// @returns the milliseconds since Timer0 was started (wraps after 49 days)
+unsigned int systime_GetMillis(void);
+
+/**
+ * Gets the cached wall-clock time
+ * @param pTime     The RTC time of the current second is copied here
+ * @returns the microseconds elapsed since the start of the current second
+ */
+unsigned int systime_GetWallTime(RTC* pTime);
+
+/// Sets the wall-clock time of the RTC, and updates the cached time
+void systime_SetWallTime(const RTC* pTime);
+
+/// @returns the cached wall-clock time in the FAT file system format (used by get_fattime())
+unsigned int systime_GetFatTime(void);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SYSTIME_H_ */
@@ -21,10 +21,11 @@ class UART0 : public UART_Base, public SingletonTemplate<UART0>
     public:
         /**
          * Initializes UART0 at the given @param baudRate
-         * @param rxQSize   The size of the receive queue  (optional, defaults to 32)
-         * @param txQSize   The size of the transmit queue (optional, defaults to 64)
+         * @param rxQSize   The size of the receive buffer  (optional, defaults to 32)
+         * @param txQSize   The size of the transmit buffer (optional, defaults to 64)
+         * @param useDma    If true, GP-DMA is used to transmit and receive data (optional)
          */
-        bool init(unsigned int baudRate, int rxQSize=32, int txQSize=64);
+        bool init(unsigned int baudRate, int rxQSize=32, int txQSize=64, bool useDma=false);
 
         /**
          * @{ \name Static functions to use for printf/scanf redirection.  @see
@@ -32,6 +33,7 @@ class UART0 : public UART_Base, public SingletonTemplate<UART0>
          */
         static char getcharIntrDriven(char unused);
         static char putcharIntrDriven(char thechar);
+        static int  writeIntrDriven(const char* pData, int len); ///< @see stdio_SetOutputWriteFunction()
         /** @} */
 
     private:
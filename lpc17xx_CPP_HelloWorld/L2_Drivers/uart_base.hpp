@@ -7,7 +7,9 @@
 
 #include "LPC17xx.h"
 #include "FreeRTOS.h"
-#include "queue.h"
+#include "semphr.h"
+#include "ringBuffer.hpp"
+#include "gpdma.h"
 
 /**
  * UART Base class that can be used to write drivers for all UART peripherals.
@@ -16,6 +18,16 @@
  *  - Call init() and configure PINSEL to select your UART pins
  *  - When your UART(#) hardware interrupt occurs, call handleInterrupt()
  *
+ * The data is buffered using lock-free ring buffers between the tasks and the
+ * UART interrupt, so a task only blocks when the transmit buffer is full, or
+ * the receive buffer is empty.  Use write() and read() to transfer blocks of
+ * data instead of calling putChar() and getChar() for each character.
+ *
+ * Optionally, the GP-DMA can be used to move the data between the buffers and
+ * the UART hardware in which case the CPU is only interrupted once per block
+ * of data being transmitted.  In this mode, the receive buffer is a circular
+ * DMA buffer that is checked upon the UART's receive interrupts.
+ *
  *  @warning This class doesn't work for UART1 due to different memory map.
  *  @ingroup Drivers
  */
@@ -40,6 +52,31 @@ class UART_Base
          */
         bool putChar(char out, unsigned int timeout=portMAX_DELAY);
 
+        /**
+         * Writes a block of data to the UART's transmit buffer
+         * @param pData     The data to write
+         * @param len       The number of bytes to write
+         * @param timeout   The maximum time to wait for space in transmit buffer
+         *                  each time the transmit buffer is found to be full.
+         * @returns the number of bytes written, which will be less than len
+         *          only if the timeout occurred.
+         * @note Tasks writing at the same time take turns, so the data of each
+         *       call is not interleaved with the data of another task.
+         */
+        int write(const char* pData, int len, unsigned int timeout=portMAX_DELAY);
+
+        /**
+         * Reads a block of data from the UART's receive buffer
+         * @param pData     The pointer to store the data read
+         * @param len       The number of bytes to read
+         * @param timeout   The maximum time to wait for more data each time the
+         *                  receive buffer is found to be empty.
+         * @returns the number of bytes read, which will be less than len only
+         *          if the timeout occurred.
+         * @note Only one task should read from the UART at a time.
+         */
+        int read(char* pData, int len, unsigned int timeout=portMAX_DELAY);
+
         /**
          * When the UART interrupt occurs, this function should be called to handle
          * future action to take due to the interrupt cause.
@@ -54,27 +91,60 @@ class UART_Base
         UART_Base(unsigned int* pUARTBaseAddr);
 
         /**
-         * Initializes the UART register including Queues, baudrate and hardware.
+         * Initializes the UART register including buffers, baudrate and hardware.
          * Parent class should call this method before initializing Pin-Connect-Block
          * @param pclk      The system peripheral clock for this UART
          * @param baudRate  The baud rate to set
-         * @param rxQSize   The receive queue size
-         * @param txQSize   The transmit queue size
+         * @param rxQSize   The receive buffer size
+         * @param txQSize   The transmit buffer size
          * @post    Sets 8-bit mode, no parity, no flow control.
          * @warning This will not initialize the PINS, so user needs to do pin
          *          selection because LPC's same UART hardware, such as UART2
          *          is available on multiple pins.
+         * @param useDma    If true, GP-DMA will be used to transmit and receive data.
+         *                  If DMA channels or DMA memory is not available, the UART
+         *                  will fall back to interrupt driven mode.
          * @note If the txQSize is too small, functions performing printf will start to block.
+         * @warning In DMA mode, if the receive buffer is not read fast enough, the
+         *          DMA will overwrite the oldest data in the receive buffer.
          */
-        bool init(unsigned int pclk, unsigned int baudRate, int rxQSize=32, int txQSize=32);
+        bool init(unsigned int pclk, unsigned int baudRate, int rxQSize=32, int txQSize=32,
+                  bool useDma=false);
 
     private:
+        /**
+         * Starts the transmission if the transmitter is not already busy sending
+         * data from the transmit buffer.
+         */
+        void kickTransmitter();
+
+        /**
+         * @{ \name DMA mode functions
+         * startTxDma() starts DMA of the largest contiguous block of the transmit buffer.
+         * updateRxFromDma() sets the receive buffer's write index to DMA's position.
+         * dmaTxComplete() is the callback from DMA interrupt when transmission completes.
+         */
+        bool initDma(int rxBufferSize, int txBufferSize);
+        void startTxDma();
+        void updateRxFromDma();
+        static void dmaTxComplete(void* pThisUart, int error);
+        /** @} */
+
         /// Pointer to UART's memory map
         LPC_UART_TypeDef* mpUARTRegBase;
 
-        xQueueHandle mRxQueue; ///< Queue for UARTs receive buffer
-        xQueueHandle mTxQueue; ///< Queue for UARTs transmit buffer
-        bool mIntrExpected;    ///< Tracks if THRE interrupt is expected
+        RingBuffer mRxBuffer;          ///< Receive buffer: ISR is producer, task is consumer
+        RingBuffer mTxBuffer;          ///< Transmit buffer: task is producer, ISR is consumer
+        xSemaphoreHandle mRxSignal;    ///< Signal given by ISR when data is received
+        xSemaphoreHandle mTxSignal;    ///< Signal given by ISR when space frees up in transmit buffer
+        xSemaphoreHandle mTxMutex;     ///< Mutex that gives one task at a time the transmit buffer
+        volatile bool mIntrExpected;   ///< Tracks if THRE (or DMA) interrupt is expected
+
+        bool mUseDma;                  ///< True if DMA mode is being used
+        int mTxDmaChannel;             ///< DMA channel used for transmission
+        int mRxDmaChannel;             ///< DMA channel used for reception
+        unsigned int mTxDmaBytes;      ///< Number of bytes being transmitted by DMA
+        unsigned char mTxDmaRequest;   ///< DMA request number of this UART's transmitter
 };
 
 
@@ -0,0 +1,179 @@
+/**
+ * @file deferredLogger.hpp
+ * @brief Records log messages in binary form so they can be formatted later by a low priority task
+ * @ingroup Utilities
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef DEFERRED_LOGGER_HPP__
+#define DEFERRED_LOGGER_HPP__
+
+#include "src/logger.hpp"   // LogType
+#include "singletonTemplate.hpp"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+
+
+#define LOGGER_DEFERRED_RECORDS     32      ///< Number of records the deferred logger can hold (power of 2)
+#define LOGGER_DEFERRED_MAX_ARGS    3       ///< Maximum arguments per log message
+#define LOGGER_DEFERRED_MSG_SIZE    128     ///< Maximum length of a formatted log message
+#define LOGGER_DEFERRED_DRAIN_MS    100     ///< How often the drain task checks for new records
+
+
+
+/**
+ * A single argument of a log message.  The raw 32-bit value of the argument is
+ * recorded, and it is only interpreted by the format string when the message is formatted.
+ *
+ * @note String arguments are recorded as pointers, so they must point to constant
+ *       strings (such as string literals) that remain valid until the message is formatted.
+ * @note Floating point arguments are not supported; passing one is a compile error.
+ *       Scale the value to an integer, for example: LOG_INFO("Temp x10: %i", (int)(t*10))
+ */
+class LogArg
+{
+    public:
+        LogArg()                    : mValue(0) {}
+        LogArg(int v)               : mValue(v) {}
+        LogArg(unsigned int v)      : mValue(v) {}
+        LogArg(long v)              : mValue(v) {}
+        LogArg(unsigned long v)     : mValue(v) {}
+        LogArg(short v)             : mValue(v) {}
+        LogArg(unsigned short v)    : mValue(v) {}
+        LogArg(char v)              : mValue(v) {}
+        LogArg(unsigned char v)     : mValue(v) {}
+        LogArg(const char* pStr)    : mValue((unsigned int) pStr) {}
+
+        inline unsigned int getValue() const { return mValue; } ///< @returns the raw value
+
+    private:
+        LogArg(float);      ///< Not supported, the value would be printed as garbage
+        LogArg(double);     ///< Not supported, the value would be printed as garbage
+
+        unsigned int mValue; ///< The raw value of the argument
+};
+
+
+
+/**
+ * The binary log record, which is 32 bytes in size.
+ * Only pointers are recorded for the strings, which reside in flash memory.
+ */
+typedef struct {
+    const char* pFormat;    ///< The printf() style format string of the message
+    const char* pFilename;  ///< The file name that logged the message
+    const char* pFuncName;  ///< The function name that logged the message
+    unsigned int timestamp; ///< The timestamp when the message was recorded
+    unsigned short lineNum; ///< The line number that logged the message
+    unsigned char type;     ///< The LogType of the message
+    unsigned char unused;   ///< Unused (padding)
+    unsigned int args[LOGGER_DEFERRED_MAX_ARGS]; ///< Raw values of the arguments
+} LogRecord;
+
+
+
+/**
+ * Deferred Logger
+ * @ingroup Utilities
+ *
+ * The LOG_ macros of filelogger.hpp use this logger when LOGGER_DEFERRED_MODE is
+ * enabled.  Logging a message only copies the format string pointer, timestamp and
+ * the raw arguments into a ring of binary records, which takes a few microseconds
+ * and never waits for the logger mutex or the file system.
+ *
+ * A low priority task converts the records into text using the format string and
+ * logs it through FileLogger with the original timestamp.  If the ring is full,
+ * the newest message is dropped, and the count of dropped messages is logged later.
+ *
+ * The ring is lock-free and safe to use from multiple tasks and ISRs at the same time.
+ * Each producer claims a record by incrementing the write index using LDREX/STREX, and
+ * then publishes the record by setting its sequence number.  If an ISR interrupts a
+ * producer, the producer's STREX fails and it simply tries again, so no critical
+ * section is needed.  ISRs should use the LOG_xxx_FROM_ISR() macros of filelogger.hpp
+ *
+ * @code
+ *  LOG_INFO("Sensor %s read %i bytes", "temp", count);
+ * @endcode
+ */
+class DeferredLogger : public SingletonTemplate<DeferredLogger>
+{
+    public:
+        /**
+         * Records a message to be formatted and logged later.
+         * @param type      The type of the message
+         * @param pFormat   The printf() style format string, must be a constant string
+         * @param pFilename The file name logging this message
+         * @param pFuncName The function name logging this message
+         * @param lineNum   The line number logging this message
+         * @param a0-a2     Optional arguments used by the format string
+         * @returns true if the message was recorded, or false if it was dropped
+         */
+        bool record(LogType type, const char* pFormat,
+                    const char* pFilename, const char* pFuncName, int lineNum,
+                    LogArg a0=LogArg(), LogArg a1=LogArg(), LogArg a2=LogArg());
+
+        /**
+         * Records a message from an ISR.  This is the same as record() except that the
+         * message is dropped if the logger has not been created yet because the
+         * logger cannot be created from an ISR.
+         * @see record() for the parameters
+         */
+        static bool recordFromISR(LogType type, const char* pFormat,
+                                  const char* pFilename, const char* pFuncName, int lineNum,
+                                  LogArg a0=LogArg(), LogArg a1=LogArg(), LogArg a2=LogArg());
+
+        /**
+         * Formats and logs a message immediately in the caller's context.
+         * This is used by the LOG_ macros when LOGGER_DEFERRED_MODE is disabled.
+         * @see record() for the parameters
+         */
+        static void logNow(LogType type, const char* pFormat,
+                           const char* pFilename, const char* pFuncName, int lineNum,
+                           LogArg a0=LogArg(), LogArg a1=LogArg(), LogArg a2=LogArg());
+
+        /// Logs all pending records, and then flushes the FileLogger
+        void flush();
+
+        /// @returns the number of messages dropped because there was no room to record them
+        inline unsigned int getDroppedCount() const { return mDroppedTotal; }
+
+        /// @returns the number of records waiting to be formatted
+        inline unsigned int getPendingCount() const { return (mWriteIdx - mReadIdx); }
+
+    private:
+        DeferredLogger();   ///< Private constructor of this Singleton class
+
+        /// Formats and logs all of the pending records
+        void drain();
+
+        /// Formats the record and logs it through FileLogger
+        static void logRecord(const LogRecord& rec);
+
+        /// The task that periodically drains the records
+        static void drainTask(void* pDeferredLogger);
+
+        LogRecord mRecords[LOGGER_DEFERRED_RECORDS]; ///< The ring of records
+
+        /**
+         * Sequence number of each record.  The record at index i of the ring is free
+         * to be written at write index w when its sequence is w, and it is ready
+         * to be read at read index r when its sequence is r+1.
+         */
+        volatile unsigned int mSequence[LOGGER_DEFERRED_RECORDS];
+
+        volatile unsigned int mWriteIdx;   ///< Free running write index (producers)
+        volatile unsigned int mReadIdx;    ///< Free running read index (drain)
+        volatile unsigned int mDropped;    ///< Dropped count not yet reported in the log
+        volatile unsigned int mDroppedTotal; ///< Total dropped messages
+        xSemaphoreHandle mDrainMutex;      ///< Allows flush() and the drain task to drain the records
+
+        static DeferredLogger* mpInstance; ///< The instance, once created, used by recordFromISR()
+
+        /// Friend class used for Singleton Template
+        friend class SingletonTemplate<DeferredLogger>;
+};
+
+
+
+#endif /* DEFERRED_LOGGER_HPP__ */
@@ -13,106 +13,161 @@
 #define LPC_LOGGER              1            ///< Set to non-zero if used with Chan's FATFS Library
 #define LOGGER_BUFFER_SIZE      512          ///< The size of the buffer, multiples of 512 recommended for File Logger
 #define LOGGER_FILE_NAME        "0:log.csv"  ///< The filename to use for logging
+#define LOGGER_DEFERRED_MODE    1            ///< If non-zero, LOG_ macros defer formatting to a low priority task
+#define LOGGER_STALL_TIMEOUT_MS 100          ///< Time a log call waits for a free buffer before dropping data
+#define LOGGER_FLUSH_TASK_PRIORITY  PRIORITY_LOW    ///< Priority of the task that writes the log file
 
 
-/// Macros to log a message that picks up filename, function name, and line number that logged the message
-#define LOG_ERROR(pMSG) FileLogger::getInstance().logError  (pMSG, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_WARN(pMSG)  FileLogger::getInstance().logWarning(pMSG, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_INFO(pMSG)  FileLogger::getInstance().logInfo   (pMSG, __FILE__, __FUNCTION__, __LINE__)
+/**
+ * Macros to log a printf() style message (with up to 3 arguments) that picks up filename,
+ * function name, and line number that logged the message.
+ * Example: LOG_WARN("Retrying after error %i", errorCode);
+ * @see DeferredLogger for the restrictions on the format string and arguments
+ */
+#if LOGGER_DEFERRED_MODE
+#define LOG_ERROR(pFMT, ...) DeferredLogger::getInstance().record(LogTypeError,   pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_WARN(pFMT, ...)  DeferredLogger::getInstance().record(LogTypeWarning, pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_INFO(pFMT, ...)  DeferredLogger::getInstance().record(LogTypeInfo,    pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(pFMT, ...) DeferredLogger::logNow(LogTypeError,   pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_WARN(pFMT, ...)  DeferredLogger::logNow(LogTypeWarning, pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_INFO(pFMT, ...)  DeferredLogger::logNow(LogTypeInfo,    pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#endif
+
+/**
+ * Macros to log a message from an ISR.  These are always deferred and never wait, and the
+ * message is dropped if the DeferredLogger has not been created yet by a task.
+ */
+#define LOG_ERROR_FROM_ISR(pFMT, ...) DeferredLogger::recordFromISR(LogTypeError,   pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_WARN_FROM_ISR(pFMT, ...)  DeferredLogger::recordFromISR(LogTypeWarning, pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOG_INFO_FROM_ISR(pFMT, ...)  DeferredLogger::recordFromISR(LogTypeInfo,    pFMT, __FILE__, __FUNCTION__, __LINE__, ##__VA_ARGS__)
 
 
 
 #include <stdio.h>          // Error message output
 #include "src/logger.hpp"   // Base class
+#include "deferredLogger.hpp"   // LOG_ macros
 #include "singletonTemplate.hpp"
 #if LPC_LOGGER
 #include "FreeRTOS.h"
 #include "semphr.h"     // FreeRTOS Semaphore for logger
+#include "task.h"
+#include "systime.h"    // Timestamp for logger
+#include "queue.h"      // Queue to the flush task
 #include "fat/ff.h"
 #endif
 
 
 
+/// The policy of when the log file is synced (committed to the disk)
+typedef enum {
+    syncEveryBuffer,    ///< Sync after writing each completed buffer
+    syncPeriodically,   ///< Write any logged data and sync once every period
+    syncOnFlushOnly     ///< Only sync when flush() is called
+} LoggerSyncPolicy;
+
+
+
 /**
  * File Logger Class
  * @ingroup Utilities
  *
- * This is an instance of logger that will print the logged data once
+ * This is an instance of logger that will save the logged data to a file once
  * the CSVLogger becomes full.
  *
- * The constructor opens a file in append mode, and when logger buffer becomes
- * full, the data is saved in the file.  This class also provides semaphore
- * and getTimestamp() function to complete the abstract logger class.
+ * The constructor opens a file in append mode.  Two buffers are used, so when
+ * the logger buffer becomes full, it is handed to a flush task that saves it to
+ * the file while the logger continues to log messages to the other buffer.  The
+ * log calls only wait if both buffers are full, and if they wait longer than
+ * LOGGER_STALL_TIMEOUT_MS, the data of the full buffer is dropped.
+ * This class also provides semaphore and getTimestamp() function to complete
+ * the abstract logger class.
  *
- * @warning DO NOT LOG IF YOU ARE INSIDE AN ISR because if Logger becomes full
- *          then we might try to use FATFS API which uses FreeRTOS API
+ * @warning Do not use the FileLogger API directly inside an ISR because if Logger becomes
+ *          full then we might try to use FreeRTOS API to hand the buffer to the flush task.
+ *          Use the LOG_xxx_FROM_ISR() macros instead, which record the message without
+ *          any locks and let the DeferredLogger task log it to the FileLogger.
  */
 class FileLogger : public CSVLogger, public SingletonTemplate<FileLogger>
 {
     public:
-    // No public API here; CSVLogger exposes public API
+        /**
+         * Writes the data logged so far to the file and syncs the file.
+         * This waits until the flush task has completed writing the data.
+         */
+        void flush();
+
+        /**
+         * Sets the sync policy of the log file
+         * @param policy    The policy, @see LoggerSyncPolicy
+         * @param periodMs  The period to use with syncPeriodically policy
+         */
+        void setSyncPolicy(LoggerSyncPolicy policy, unsigned int periodMs=1000);
+
+        /// @{ \name Statistics of the logger
+        inline unsigned int getStalledCount() const  { return mStalledCount;  } ///< @returns times a log call waited for a free buffer
+        inline unsigned int getDroppedCount() const  { return mDroppedCount;  } ///< @returns number of messages dropped
+        inline unsigned int getBuffersWritten() const { return mBuffersWritten; } ///< @returns number of buffers written to file
+        inline unsigned int getSyncCount() const     { return mSyncCount;     } ///< @returns number of times the file was synced
+        /// @}
 
     protected:
         /// Protected Constructor for Singleton class
-        FileLogger() : CSVLogger(mBuff,LOGGER_BUFFER_SIZE), mFileOpened(false)
-        {
-#if LPC_LOGGER
-            mSemHandle = xSemaphoreCreateMutex();
-
-            // Open the logger file and seek to end of file
-            if(FR_OK == f_open(&mOutFile, LOGGER_FILE_NAME, FA_OPEN_ALWAYS|FA_WRITE))
-            {
-                if(FR_OK == f_lseek(&mOutFile, f_size(&mOutFile)))
-                {
-                    mFileOpened = true;
-                }
-            }
-            // Leave the file opened to maximize performance
-#endif
-        }
-
-        /// Pure-virtual base class function implementation
-        void handleCompletedBuffer(char* pBuff, unsigned int size)
-        {
-            bool success = false;
-            if(mFileOpened)
-            {
-#if LPC_LOGGER
-                unsigned int bytesWritten = 0;
-                if(FR_OK == f_write(&mOutFile, pBuff, size, &bytesWritten))
-                {
-                    success = (size == bytesWritten);
-                    if(FR_OK != f_sync(&mOutFile)) {
-                        success = false;
-                    }
-                }
-#endif
-            }
-            if(!success) {
-                puts("Error logging data to file, here is a printout of the data: ");
-                for(unsigned int i=0; i<size; i++) {
-                    putchar(pBuff[i]);
-                }
-            }
-        }
+        FileLogger();
+
+        /**
+         * Pure-virtual base class function implementation that hands the completed buffer
+         * to the flush task, and switches the logger to the other buffer.
+         */
+        void handleCompletedBuffer(char* pBuff, unsigned int size);
 
 #if LPC_LOGGER
         /// @{ \name Virtual function overrides:
             void semTake(){ xSemaphoreTake(mSemHandle, portMAX_DELAY); }
             void semGive(){ xSemaphoreGive(mSemHandle);                }
-            unsigned int getTimestamp() { return xTaskGetTickCountFromISR(); }
+            unsigned int getTimestamp() { return systime_GetMillis(); }
         /// @}
 #endif
 
     private:
-        bool mFileOpened;            ///< Set by constructor if logger file was opened successfully
+        /// Writes the buffer to the file, and syncs the file if @param sync is true
+        void writeBuffer(const char* pBuff, unsigned int size, bool sync);
+
+#if LPC_LOGGER
+        /// The flush task that writes the completed buffers to the file
+        static void flushTask(void* pFileLogger);
+
+        /// The request sent to the flush task
+        typedef struct {
+            const char* pBuff;  ///< The completed buffer, or NULL to sync the file
+            unsigned int size;  ///< The size of data in the buffer
+        } FlushRequest;
+
+        /// Writes the buffer of a request (or syncs the file), and signals the task that made the request
+        void handleFlushRequest(const FlushRequest& request);
+#endif
+
+        bool mFileOpened;               ///< Set by constructor if logger file was opened successfully
+        bool mUnsyncedData;             ///< Set when data is written to the file without syncing
+        LoggerSyncPolicy mSyncPolicy;   ///< The sync policy
+        unsigned int mSyncPeriodMs;     ///< The sync period of syncPeriodically policy
+        unsigned int mStalledCount;     ///< Number of times a log call had to wait for the flush task
+        unsigned int mDroppedCount;     ///< Number of messages dropped because flush task didn't free a buffer
+        unsigned int mBuffersWritten;   ///< Number of buffers written to the file
+        unsigned int mSyncCount;        ///< Number of times the file was synced
 #if LPC_LOGGER
-        FIL mOutFile;                ///< The filehandle of the logger file
-        xSemaphoreHandle mSemHandle; ///< Semaphore for the CSVLogger
+        FIL mOutFile;                   ///< The filehandle of the logger file
+        xSemaphoreHandle mSemHandle;    ///< Semaphore for the CSVLogger
+        xSemaphoreHandle mSpareFree;    ///< Given by the flush task when the spare buffer is free
+        xSemaphoreHandle mSyncDone;     ///< Given by the flush task when the sync requested by flush() is done
+        xSemaphoreHandle mFlushMutex;   ///< Allows one flush() at a time
+        xQueueHandle mFlushQueue;       ///< Queue of FlushRequest to the flush task
+        xTaskHandle mFlushTaskHandle;   ///< The flush task handle
 #endif
 
-        /// The buffer to log data until it gets full
-        char mBuff[LOGGER_BUFFER_SIZE];
+        /// The two buffers to log data: one is being logged while the other is saved
+        char mBuff[2][LOGGER_BUFFER_SIZE];
+        unsigned char mActiveBuff;      ///< Index of mBuff being used by the logger
 
         /// Friend class used for Singleton Template
         friend class SingletonTemplate<FileLogger>;
@@ -0,0 +1,306 @@
+/**
+ * @file format.hpp
+ * @brief Provides type-safe, allocation free formatting of text
+ * @ingroup Utilities
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef FORMAT_HPP__
+#define FORMAT_HPP__
+
+#include "str.hpp"
+#include "io_functions.h"   // stdio_Write()
+
+
+
+/// Size of the stack buffer used by StdoutFormatter before it outputs the data
+#define FORMAT_STDOUT_BUFFER_SIZE   64
+
+
+
+/**
+ * Low level conversion functions used by the Formatter.
+ * These write the characters without NULL terminator, and return the number
+ * of characters written.
+ * @ingroup Utilities
+ */
+class FormatCore
+{
+    public:
+        /// Maximum characters written by any of the conversion functions
+        static const int maxChars = 24;
+
+        /// Converts unsigned value to decimal using a digit-pair lookup table
+        static int toDec(char* pOut, unsigned int value);
+
+        /// Converts signed value to decimal using a digit-pair lookup table
+        static int toDec(char* pOut, int value);
+
+        /// Converts value to hexadecimal with uppercase or lowercase letters
+        static int toHex(char* pOut, unsigned int value, bool upperCase=true);
+
+        /**
+         * Converts float to fixed point decimal without any floating point division.
+         * The integer and fraction parts are separated, and the fraction part is
+         * scaled by power of 10 to convert it to an integer.
+         * @param decimals  The digits after decimal point (0-6)
+         * @note  Values beyond the range of 32-bit integer are printed as "ovf"
+         */
+        static int toFixed(char* pOut, float value, unsigned int decimals);
+
+    private:
+        FormatCore();   ///< Only static functions, so no instance
+};
+
+
+
+/**
+ * @{ \name Format specifiers to use with the Formatter.
+ * Example: formatter << FmtDec(x, 3, '0') << FmtHex(y, 8) << FmtFixed(f, 2);
+ */
+/// Decimal value with minimum width and padding char
+struct FmtDec {
+    FmtDec(int v, unsigned char w=0, char pad=' ') : value(v), width(w), padChar(pad) {}
+    int value; unsigned char width; char padChar;
+};
+/// Unsigned decimal value with minimum width and padding char
+struct FmtUDec {
+    FmtUDec(unsigned int v, unsigned char w=0, char pad=' ') : value(v), width(w), padChar(pad) {}
+    unsigned int value; unsigned char width; char padChar;
+};
+/// Hexadecimal value with minimum width (zero padded)
+struct FmtHex {
+    FmtHex(unsigned int v, unsigned char w=0, bool upper=true) : value(v), width(w), upperCase(upper) {}
+    unsigned int value; unsigned char width; bool upperCase;
+};
+/// Float printed with fixed number of digits after decimal point, with minimum width
+struct FmtFixed {
+    FmtFixed(float v, unsigned char d=2, unsigned char w=0) : value(v), decimals(d), width(w) {}
+    float value; unsigned char decimals; unsigned char width;
+};
+/// String with minimum width, padded on the right (left justified)
+struct FmtStr {
+    FmtStr(const char* s, unsigned char w=0) : pStr(s), width(w) {}
+    const char* pStr; unsigned char width;
+};
+/** @} */
+
+
+
+/**
+ * Formatter class that writes text to its Sink.
+ * The format is given by the types of the values written to the formatter, so
+ * unlike printf(), nothing is parsed at run-time, and a wrong format can never
+ * read the wrong type of argument.  The compiler selects the conversion function
+ * for each value, and the text is written to the Sink in blocks.
+ *
+ * The SinkType needs to provide: void write(const char* pData, int len)
+ *
+ * @code
+ *  char buffer[32];
+ *  BufferFormatter f(buffer, sizeof(buffer));
+ *  f << "Temp: " << FmtFixed(temperature, 1) << "F, Raw: " << FmtHex(raw, 4);
+ *  puts(buffer);
+ *
+ *  StrFormatter(myStr) << "Count: " << count;          // Appends to str
+ *  StdoutFormatter() << "Uptime: " << seconds << "\n"; // Outputs when statement ends
+ * @endcode
+ *
+ * @ingroup Utilities
+ */
+template <typename SinkType>
+class Formatter : public SinkType
+{
+    public:
+        /// @{ Constructors that forward the parameters to the SinkType
+        Formatter() : SinkType() {}
+        template <typename P1> Formatter(P1& p1) : SinkType(p1) {}
+        template <typename P1, typename P2> Formatter(P1 p1, P2 p2) : SinkType(p1, p2) {}
+        /// @}
+
+        Formatter& operator<<(const char* pStr)
+        {
+            if (pStr) {
+                int len = 0;
+                while (pStr[len]) {
+                    len++;
+                }
+                SinkType::write(pStr, len);
+            }
+            return *this;
+        }
+        Formatter& operator<<(const str& s)   { return (*this << s()); }
+        Formatter& operator<<(char c)         { SinkType::write(&c, 1); return *this; }
+        Formatter& operator<<(bool b)         { return (*this << (b ? "true" : "false")); }
+        Formatter& operator<<(int v)          { return writeConverted(FormatCore::toDec(mScratch, v), 0, ' '); }
+        Formatter& operator<<(unsigned int v) { return writeConverted(FormatCore::toDec(mScratch, v), 0, ' '); }
+        Formatter& operator<<(long v)          { return (*this << (int) v); }
+        Formatter& operator<<(unsigned long v) { return (*this << (unsigned int) v); }
+        Formatter& operator<<(short v)          { return (*this << (int) v); }
+        Formatter& operator<<(unsigned short v) { return (*this << (unsigned int) v); }
+        Formatter& operator<<(unsigned char v)  { return (*this << (unsigned int) v); }
+        Formatter& operator<<(float v)  { return writeConverted(FormatCore::toFixed(mScratch, v, 3), 0, ' '); }
+        Formatter& operator<<(double v) { return (*this << (float) v); }
+
+        Formatter& operator<<(const FmtDec& f)
+        {
+            return writeConverted(FormatCore::toDec(mScratch, f.value), f.width, f.padChar);
+        }
+        Formatter& operator<<(const FmtUDec& f)
+        {
+            return writeConverted(FormatCore::toDec(mScratch, f.value), f.width, f.padChar);
+        }
+        Formatter& operator<<(const FmtHex& f)
+        {
+            return writeConverted(FormatCore::toHex(mScratch, f.value, f.upperCase), f.width, '0');
+        }
+        Formatter& operator<<(const FmtFixed& f)
+        {
+            return writeConverted(FormatCore::toFixed(mScratch, f.value, f.decimals), f.width, ' ');
+        }
+        Formatter& operator<<(const FmtStr& f)
+        {
+            int len = 0;
+            while (f.pStr && f.pStr[len]) {
+                len++;
+            }
+            SinkType::write(f.pStr, len);
+            writePadding(len, f.width, ' ');
+            return *this;
+        }
+
+    private:
+        /**
+         * Writes the converted chars from mScratch padded on the left to the given
+         * width.  Zero padding is inserted after the minus sign.
+         */
+        Formatter& writeConverted(int len, unsigned char width, char padChar)
+        {
+            const char* pData = mScratch;
+            if (len < width)
+            {
+                if ('0' == padChar && '-' == mScratch[0]) {
+                    SinkType::write(pData++, 1);
+                    len--;
+                    width--;
+                }
+                writePadding(len, width, padChar);
+            }
+
+            SinkType::write(pData, len);
+            return *this;
+        }
+
+        /// Writes padChar to make len equal to width
+        void writePadding(int len, unsigned char width, char padChar)
+        {
+            while (len++ < width) {
+                SinkType::write(&padChar, 1);
+            }
+        }
+
+        char mScratch[FormatCore::maxChars];   ///< Scratch memory for conversions
+};
+
+
+
+/**
+ * Sink that writes to a caller's buffer and keeps the buffer NULL terminated.
+ * Data that doesn't fit is discarded, and isTruncated() can be used to check this.
+ * @ingroup Utilities
+ */
+class FormatBufferSink
+{
+    public:
+        FormatBufferSink(char* pBuffer, int size) :
+            mpBuffer(pBuffer), mSize(size), mLen(0), mTruncated(false)
+        {
+            if (mSize > 0) {
+                mpBuffer[0] = '\0';
+            }
+        }
+
+        void write(const char* pData, int len)
+        {
+            if (mLen + len >= mSize) {
+                mTruncated = true;
+                len = mSize - mLen - 1;
+            }
+            for (int i = 0; i < len; i++) {
+                mpBuffer[mLen++] = pData[i];
+            }
+            if (mSize > 0) {
+                mpBuffer[mLen] = '\0';
+            }
+        }
+
+        inline int getLen() const            { return mLen;       }  ///< @returns length of the text
+        inline const char* c_str() const     { return mpBuffer;   }  ///< @returns the buffer
+        inline bool isTruncated() const      { return mTruncated; }  ///< @returns true if data didn't fit
+
+    private:
+        char* mpBuffer;     ///< The buffer
+        int mSize;          ///< Size of the buffer
+        int mLen;           ///< Length of data written to buffer
+        bool mTruncated;    ///< Set to true if data didn't fit to the buffer
+};
+
+/**
+ * Sink that appends to a str
+ * @ingroup Utilities
+ */
+class FormatStrSink
+{
+    public:
+        FormatStrSink(str& s) : mStr(s) {}
+        void write(const char* pData, int len) { mStr.append(pData, len); }
+
+    private:
+        str& mStr;  ///< The str to write to
+};
+
+/**
+ * Sink that outputs to stdout using stdio_Write().  Data is collected in a small
+ * buffer which is output when full and upon destruction.
+ * @ingroup Utilities
+ */
+class FormatStdoutSink
+{
+    public:
+        FormatStdoutSink() : mLen(0) {}
+        ~FormatStdoutSink() { flush(); }
+
+        void write(const char* pData, int len)
+        {
+            while (len-- > 0)
+            {
+                if (mLen >= (int) sizeof(mBuffer)) {
+                    flush();
+                }
+                mBuffer[mLen++] = *pData++;
+            }
+        }
+
+        /// Outputs the buffered data
+        void flush()
+        {
+            if (mLen > 0) {
+                stdio_Write(mBuffer, mLen);
+                mLen = 0;
+            }
+        }
+
+    private:
+        char mBuffer[FORMAT_STDOUT_BUFFER_SIZE];    ///< Buffer to collect the data
+        int mLen;                                   ///< Length of the buffered data
+};
+
+
+
+typedef Formatter<FormatBufferSink> BufferFormatter;    ///< Formatter that writes to caller's buffer
+typedef Formatter<FormatStrSink>    StrFormatter;       ///< Formatter that appends to a str
+typedef Formatter<FormatStdoutSink> StdoutFormatter;    ///< Formatter that outputs to stdout
+
+
+
+#endif /* FORMAT_HPP__ */
@@ -0,0 +1,183 @@
+/**
+ * @file profiler.hpp
+ * @brief Cycle accurate profiling based on the DWT cycle counter of the Cortex-M3
+ * @ingroup Utilities
+ *
+ * The DWT cycle counter increments at the CPU clock, so a block of code can be timed
+ * to a single CPU cycle.  Timing is recorded to named probes, and each probe accumulates
+ * the count, min, max, mean and a histogram of its timings.  The "prof" terminal command
+ * prints and resets all the probes.
+ *
+ * Example:
+ * @code
+ *      void foo()
+ *      {
+ *          PROFILE_SCOPE("foo");   // Time from here until the end of the function
+ *          // ...
+ *      }
+ *
+ *      // Probe shared by more than one place in the code
+ *      static ProfileProbe gSdRead = PROFILE_PROBE_INITIALIZER("sd read");
+ *      void bar()
+ *      {
+ *          ProfileScope timeThis(gSdRead);
+ *          // ...
+ *      }
+ * @endcode
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef PROFILER_HPP__
+#define PROFILER_HPP__
+
+#include "systime.h"        // systime_GetMicros() used by PRINT_EXECUTION_SPEED()
+
+
+
+#define PROFILER_HIST_BUCKETS   8       ///< Histogram buckets per probe, each bucket covers 4x of the previous one
+#define PROFILER_HIST_MIN_BITS  6       ///< Timings less than 2^6 cycles go in the first histogram bucket
+
+#define PROFILER_DWT_CTRL       (*(volatile unsigned int*) 0xE0001000)  ///< DWT Control Register
+#define PROFILER_DWT_CYCCNT     (*(volatile unsigned int*) 0xE0001004)  ///< DWT Cycle Count Register
+
+
+
+/**
+ * A named probe point that accumulates timing in CPU cycles.
+ * This is a plain structure so a static probe inside a function (or an ISR) is initialized
+ * at compile time by PROFILE_PROBE_INITIALIZER().  A probe adds itself to the list of
+ * probes when it is recorded the first time, or when Profiler::addProbe() is called.
+ */
+struct ProfileProbe
+{
+    const char* pName;          ///< The name of the probe
+    unsigned int count;         ///< Number of timings recorded
+    unsigned int minCycles;     ///< Minimum timing
+    unsigned int maxCycles;     ///< Maximum timing
+    unsigned long long totalCycles; ///< Sum of all timings (for the mean)
+    unsigned int hist[PROFILER_HIST_BUCKETS]; ///< Histogram of the timings @see Profiler::getBucketLimit()
+    ProfileProbe* pNext;        ///< The next probe in the list of probes
+    bool added;                 ///< True once added to the list of probes
+
+    /// Records a timing of @param cycles (safe to call from an ISR)
+    void record(unsigned int cycles);
+
+    /// Clears the accumulated timings
+    void reset();
+
+    /// @returns the mean timing in cycles
+    unsigned int getMeanCycles() const { return count ? (unsigned int) (totalCycles / count) : 0; }
+};
+
+/// Initializer of a ProfileProbe with the name given by @param name
+#define PROFILE_PROBE_INITIALIZER(name)     { name, 0, 0xFFFFFFFF, 0, 0, {0}, 0, false }
+
+
+
+/**
+ * Profiler functions
+ * @ingroup Utilities
+ */
+class Profiler
+{
+    public:
+        /**
+         * Enables the DWT cycle counter, and measures the overhead of a ProfileScope,
+         * which is subtracted from every timing.
+         */
+        static void init();
+
+        /// @returns the DWT cycle counter (wraps every 42 seconds at 100Mhz)
+        static inline unsigned int getCycles() { return PROFILER_DWT_CYCCNT; }
+
+        /// @returns the @param cycles converted to microseconds
+        static unsigned int cyclesToUs(unsigned int cycles);
+
+        /// @returns the timing overhead subtracted from each recorded timing
+        static inline unsigned int getOverheadCycles() { return mOverheadCycles; }
+
+        /// Adds the @param probe to the list of probes if it is not already added
+        static void addProbe(ProfileProbe& probe);
+
+        /// @returns the first probe, use ProfileProbe::pNext to get to the next probe
+        static inline ProfileProbe* getFirstProbe() { return mpFirstProbe; }
+
+        /// Resets all the probes
+        static void resetAll();
+
+        /// Prints all the probes to stdio
+        static void printAll();
+
+        /// Prints the time elapsed since @param startMicros of systime_GetMicros()
+        static void printDurationSince(unsigned long long startMicros);
+
+        /// @returns the histogram bucket of a timing given by @param cycles
+        static unsigned int getBucket(unsigned int cycles);
+
+        /**
+         * @returns the upper limit (exclusive) of the histogram bucket @param bucket in cycles.
+         * The last bucket has no limit and returns 0.
+         */
+        static unsigned int getBucketLimit(unsigned int bucket);
+
+    private:
+        Profiler(); ///< Only static functions are used
+
+        static ProfileProbe* mpFirstProbe;      ///< The list of probes
+        static unsigned int mOverheadCycles;    ///< Cycles taken by ProfileScope itself
+};
+
+
+
+/**
+ * Scoped timer that records the cycles from its construction until its destruction
+ * to a probe.
+ */
+class ProfileScope
+{
+    public:
+        ProfileScope(ProfileProbe& probe) : mProbe(probe), mStartCycles(Profiler::getCycles()) {}
+        ~ProfileScope() { mProbe.record(Profiler::getCycles() - mStartCycles); }
+
+    private:
+        ProfileScope(const ProfileScope&);              ///< Disallow copy
+        ProfileScope& operator=(const ProfileScope&);   ///< Disallow assignment
+
+        ProfileProbe& mProbe;           ///< The probe to record the timing to
+        const unsigned int mStartCycles;///< The cycle count at construction
+};
+
+
+
+/** @{ Helper macros to create unique names for PROFILE_SCOPE() */
+#define PROFILER_CONCAT_(a, b)      a##b
+#define PROFILER_CONCAT(a, b)       PROFILER_CONCAT_(a, b)
+/** @} */
+
+/**
+ * Times the code from this point until the end of the enclosing scope to a probe
+ * named @param name
+ */
+#define PROFILE_SCOPE(name)                                                                             \
+        static ProfileProbe PROFILER_CONCAT(profProbe_, __LINE__) = PROFILE_PROBE_INITIALIZER(name);  \
+        ProfileScope PROFILER_CONCAT(profScope_, __LINE__)(PROFILER_CONCAT(profProbe_, __LINE__))
+
+/**
+ * Macro that can be used to print the timing/performance of a block
+ * This uses the 64-bit microsecond system time rather than the cycle counter, which
+ * wraps in less than a minute, so it can time long commands such as a file copy.
+ * Example:
+ * @code
+ *      PRINT_EXECUTION_SPEED()
+ *      {
+ *          // ...
+ *      }
+ *      // At the end, the time taken between this block will be printed
+ * @endcode
+ */
+#define PRINT_EXECUTION_SPEED() for(unsigned long long __startUs=systime_GetMicros(), __once=1; __once; \
+                                    Profiler::printDurationSince(__startUs),__once=0)
+
+
+
+#endif /* PROFILER_HPP__ */
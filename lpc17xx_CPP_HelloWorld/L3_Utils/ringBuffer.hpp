@@ -0,0 +1,242 @@
+/**
+ * @file ringBuffer.hpp
+ * @brief Lock-free Single-Producer Single-Consumer byte ring buffer
+ * @ingroup Utilities
+ *
+ * Version: 10172012    Initial
+ */
+#ifndef RINGBUFFER_HPP_
+#define RINGBUFFER_HPP_
+
+#include <stdlib.h>     // malloc()
+#include <string.h>     // memcpy()
+
+
+
+/**
+ * Compiler barrier to make sure that data is written to (or read from) the buffer
+ * before the read/write index is published to the other side.
+ * Cortex-M3 is a single core, in-order CPU, so compiler barrier is sufficient.
+ */
+#define RING_BUFFER_BARRIER()    __asm volatile ("" ::: "memory")
+
+
+
+/**
+ * Ring Buffer of bytes that is safe to use between ONE producer and ONE consumer
+ * without any critical sections or FreeRTOS queues.  The producer only modifies
+ * the write index, and the consumer only modifies the read index.  The producer
+ * and consumer can be a task and an ISR, or two different tasks.
+ *
+ * One byte of the allocated memory is never used to distinguish between full and
+ * empty buffer, so size given to init() is the actual number of bytes that can
+ * be stored in the buffer.
+ *
+ * Usage:
+ * @code
+ *  RingBuffer ring;
+ *  ring.init(64);
+ *
+ *  // Producer:
+ *  ring.write("hello", 5);
+ *
+ *  // Consumer:
+ *  char c = 0;
+ *  while (ring.get(&c)) {
+ *      putchar(c);
+ *  }
+ * @endcode
+ *
+ * @ingroup Utilities
+ */
+class RingBuffer
+{
+    public:
+        /// Default constructor, init() must be called before using the buffer.
+        RingBuffer() : mpBuffer(0), mSize(0), mWriteIdx(0), mReadIdx(0)
+        {
+        }
+
+        /**
+         * Allocates the memory for the buffer.
+         * @param capacity  The number of bytes this buffer should be able to store
+         * @returns true if memory was allocated successfully
+         */
+        bool init(unsigned int capacity)
+        {
+            return init((char*)malloc(capacity + 1), capacity + 1);
+        }
+
+        /**
+         * Uses the memory given to this function as the buffer's memory.
+         * @param pMemory   The memory this buffer should use
+         * @param memSize   The size of the memory, buffer can store (memSize-1) bytes
+         * @returns true if memory was given and buffer is ready for use
+         */
+        bool init(char* pMemory, unsigned int memSize)
+        {
+            mpBuffer = pMemory;
+            mSize = (0 == pMemory) ? 0 : memSize;
+            mWriteIdx = mReadIdx = 0;
+            return (0 != mpBuffer && mSize > 1);
+        }
+
+        /// @returns the number of bytes available to read from the buffer
+        inline unsigned int getCount() const
+        {
+            const unsigned int w = mWriteIdx;
+            const unsigned int r = mReadIdx;
+            return (w >= r) ? (w - r) : (mSize - r + w);
+        }
+
+        /// @returns the number of bytes that can be written to the buffer
+        inline unsigned int getFreeSpace() const { return (mSize - 1 - getCount()); }
+
+        inline bool isEmpty() const { return (mWriteIdx == mReadIdx); }      ///< @returns true if buffer is empty
+        inline bool isFull()  const { return (0 == getFreeSpace());    }      ///< @returns true if buffer is full
+        inline unsigned int getCapacity() const { return mSize ? mSize - 1 : 0; } ///< @returns the buffer's capacity
+
+        /**
+         * Puts a single byte to the buffer (Producer side)
+         * @returns true if the byte was stored, or false if the buffer was full.
+         */
+        inline bool put(const char c)
+        {
+            const unsigned int next = nextIndex(mWriteIdx);
+            if (next == mReadIdx) {
+                return false;
+            }
+
+            mpBuffer[mWriteIdx] = c;
+            RING_BUFFER_BARRIER();
+            mWriteIdx = next;
+            return true;
+        }
+
+        /**
+         * Gets a single byte from the buffer (Consumer side)
+         * @returns true if the byte was obtained, or false if the buffer was empty.
+         */
+        inline bool get(char* pChar)
+        {
+            const unsigned int r = mReadIdx;
+            if (r == mWriteIdx) {
+                return false;
+            }
+
+            *pChar = mpBuffer[r];
+            RING_BUFFER_BARRIER();
+            mReadIdx = nextIndex(r);
+            return true;
+        }
+
+        /**
+         * Writes up to @param len bytes from @param pData to the buffer (Producer side)
+         * Data is copied in at most two memcpy() operations.
+         * @returns the number of bytes actually written, which can be less than len
+         *          if the buffer does not have enough free space.
+         */
+        unsigned int write(const char* pData, unsigned int len)
+        {
+            const unsigned int free = getFreeSpace();
+            if (len > free) {
+                len = free;
+            }
+
+            const unsigned int w = mWriteIdx;
+            const unsigned int tillEnd = mSize - w;
+            if (len <= tillEnd) {
+                memcpy(mpBuffer + w, pData, len);
+            }
+            else {
+                memcpy(mpBuffer + w, pData, tillEnd);
+                memcpy(mpBuffer, pData + tillEnd, len - tillEnd);
+            }
+
+            RING_BUFFER_BARRIER();
+            mWriteIdx = (w + len) % mSize;
+            return len;
+        }
+
+        /**
+         * Reads up to @param len bytes from the buffer to @param pData (Consumer side)
+         * Data is copied in at most two memcpy() operations.
+         * @returns the number of bytes actually read.
+         */
+        unsigned int read(char* pData, unsigned int len)
+        {
+            const unsigned int count = getCount();
+            if (len > count) {
+                len = count;
+            }
+
+            const unsigned int r = mReadIdx;
+            const unsigned int tillEnd = mSize - r;
+            if (len <= tillEnd) {
+                memcpy(pData, mpBuffer + r, len);
+            }
+            else {
+                memcpy(pData, mpBuffer + r, tillEnd);
+                memcpy(pData + tillEnd, mpBuffer, len - tillEnd);
+            }
+
+            RING_BUFFER_BARRIER();
+            mReadIdx = (r + len) % mSize;
+            return len;
+        }
+
+        /**
+         * @{ \name Functions for hardware (such as DMA) acting as producer or consumer
+         * When the hardware moves the data, the software only needs to move the
+         * read or write index after the hardware is done.
+         */
+        /// @returns the buffer memory given to init()
+        inline char* getMemory() const { return mpBuffer; }
+
+        /// @returns the size of the buffer memory given to init()
+        inline unsigned int getMemorySize() const { return mSize; }
+
+        /**
+         * Gets the largest block of data that can be read without wrap-around
+         * @param ppData  The pointer to the data will be stored here
+         * @returns the number of bytes of contiguous data
+         */
+        inline unsigned int getContiguousData(const char** ppData) const
+        {
+            const unsigned int w = mWriteIdx;
+            const unsigned int r = mReadIdx;
+            *ppData = mpBuffer + r;
+            return (w >= r) ? (w - r) : (mSize - r);
+        }
+
+        /// Discards @param len bytes from the buffer after hardware has read them (Consumer side)
+        inline void consume(unsigned int len)
+        {
+            RING_BUFFER_BARRIER();
+            mReadIdx = (mReadIdx + len) % mSize;
+        }
+
+        /// Sets the write index up to which the hardware has written the data (Producer side)
+        inline void setWriteIndex(unsigned int idx)
+        {
+            RING_BUFFER_BARRIER();
+            mWriteIdx = idx % mSize;
+        }
+        /** @} */
+
+    private:
+        /// @returns the next index after @param idx with wrap-around
+        inline unsigned int nextIndex(unsigned int idx) const
+        {
+            return (++idx >= mSize) ? 0 : idx;
+        }
+
+        char* mpBuffer;                     ///< The buffer memory
+        unsigned int mSize;                 ///< Size of the buffer memory
+        volatile unsigned int mWriteIdx;    ///< Write index, only modified by the producer
+        volatile unsigned int mReadIdx;     ///< Read index, only modified by the consumer
+};
+
+
+
+#endif /* RINGBUFFER_HPP_ */
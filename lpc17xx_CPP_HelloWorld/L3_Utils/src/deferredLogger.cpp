@@ -0,0 +1,183 @@
+#include <stdio.h>          // sniprintf()
+#include "deferredLogger.hpp"
+#include "filelogger.hpp"
+#include "task.h"
+#include "LPC17xx.h"        // __LDREXW(), __STREXW()
+#include "systime.h"        // systime_GetMillis()
+
+
+
+/**
+ * Atomically adds @param value to the variable pointed by @param pVar
+ * @returns the previous value of the variable
+ */
+static unsigned int atomicAdd(volatile unsigned int* pVar, unsigned int value)
+{
+    unsigned int previous = 0;
+    do {
+        previous = __LDREXW((uint32_t*) pVar);
+    } while (0 != __STREXW(previous + value, (uint32_t*) pVar));
+    return previous;
+}
+
+/// Atomically sets the variable pointed by @param pVar to zero, @returns its previous value
+static unsigned int atomicClear(volatile unsigned int* pVar)
+{
+    unsigned int previous = 0;
+    do {
+        previous = __LDREXW((uint32_t*) pVar);
+    } while (0 != __STREXW(0, (uint32_t*) pVar));
+    return previous;
+}
+
+
+
+DeferredLogger* DeferredLogger::mpInstance = 0;
+
+DeferredLogger::DeferredLogger() :
+    mWriteIdx(0), mReadIdx(0), mDropped(0), mDroppedTotal(0)
+{
+    for (unsigned int i = 0; i < LOGGER_DEFERRED_RECORDS; i++) {
+        mSequence[i] = i;
+    }
+
+    mDrainMutex = xSemaphoreCreateMutex();
+    xTaskCreate(drainTask, (signed char*)"logdrain", STACK_BYTES(1024), this, PRIORITY_LOW, 0);
+    mpInstance = this;
+}
+
+bool DeferredLogger::record(LogType type, const char* pFormat,
+                            const char* pFilename, const char* pFuncName, int lineNum,
+                            LogArg a0, LogArg a1, LogArg a2)
+{
+    const unsigned int timestamp = systime_GetMillis();
+    unsigned int pos = 0;
+
+    // Claim a record by moving the write index if the record at the write index is free
+    while (1)
+    {
+        pos = __LDREXW((uint32_t*) &mWriteIdx);
+        const int diff = (int) (mSequence[pos % LOGGER_DEFERRED_RECORDS] - pos);
+
+        if (0 == diff) {
+            if (0 == __STREXW(pos + 1, (uint32_t*) &mWriteIdx)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // Record is not yet read by the drain task, so the ring is full
+            __CLREX();
+            atomicAdd(&mDropped, 1);
+            atomicAdd(&mDroppedTotal, 1);
+            return false;
+        }
+        else {
+            // Another producer claimed this record after we read the write index
+            __CLREX();
+        }
+    }
+
+    LogRecord& rec = mRecords[pos % LOGGER_DEFERRED_RECORDS];
+    rec.pFormat   = pFormat;
+    rec.pFilename = pFilename;
+    rec.pFuncName = pFuncName;
+    rec.timestamp = timestamp;
+    rec.lineNum   = lineNum;
+    rec.type      = type;
+    rec.args[0]   = a0.getValue();
+    rec.args[1]   = a1.getValue();
+    rec.args[2]   = a2.getValue();
+
+    // Publish the record to the drain task after the record is written
+    __DMB();
+    mSequence[pos % LOGGER_DEFERRED_RECORDS] = pos + 1;
+    return true;
+}
+
+bool DeferredLogger::recordFromISR(LogType type, const char* pFormat,
+                                   const char* pFilename, const char* pFuncName, int lineNum,
+                                   LogArg a0, LogArg a1, LogArg a2)
+{
+    DeferredLogger* pLogger = mpInstance;
+    return (0 != pLogger) && pLogger->record(type, pFormat, pFilename, pFuncName, lineNum, a0, a1, a2);
+}
+
+void DeferredLogger::logNow(LogType type, const char* pFormat,
+                            const char* pFilename, const char* pFuncName, int lineNum,
+                            LogArg a0, LogArg a1, LogArg a2)
+{
+    LogRecord rec;
+    rec.pFormat   = pFormat;
+    rec.pFilename = pFilename;
+    rec.pFuncName = pFuncName;
+    rec.timestamp = systime_GetMillis();
+    rec.lineNum   = lineNum;
+    rec.type      = type;
+    rec.args[0]   = a0.getValue();
+    rec.args[1]   = a1.getValue();
+    rec.args[2]   = a2.getValue();
+    logRecord(rec);
+}
+
+void DeferredLogger::flush()
+{
+    drain();
+    FileLogger::getInstance().flush();
+}
+
+void DeferredLogger::drain()
+{
+    xSemaphoreTake(mDrainMutex, portMAX_DELAY);
+    {
+        while (1)
+        {
+            // Stop at the first record that is not yet published by its producer
+            const unsigned int pos = mReadIdx;
+            const unsigned int idx = pos % LOGGER_DEFERRED_RECORDS;
+            if (mSequence[idx] != pos + 1) {
+                break;
+            }
+
+            // Copy the record before freeing it for the producers
+            const LogRecord rec = mRecords[idx];
+            __DMB();
+            mSequence[idx] = pos + LOGGER_DEFERRED_RECORDS;
+            mReadIdx = pos + 1;
+
+            logRecord(rec);
+        }
+
+        if (0 != mDropped)
+        {
+            const unsigned int dropped = atomicClear(&mDropped);
+            LogRecord rec = { "%u log messages were dropped", 0, 0, systime_GetMillis(),
+                              0, LogTypeWarning, 0, { dropped, 0, 0 } };
+            logRecord(rec);
+        }
+    }
+    xSemaphoreGive(mDrainMutex);
+}
+
+void DeferredLogger::logRecord(const LogRecord& rec)
+{
+    /**
+     * The arguments are given as 32-bit values, which are interpreted by
+     * the format string the same way as the original arguments since
+     * int, long and pointers are all 32-bit on this processor.
+     */
+    char msg[LOGGER_DEFERRED_MSG_SIZE];
+    sniprintf(msg, sizeof(msg), rec.pFormat, rec.args[0], rec.args[1], rec.args[2]);
+
+    FileLogger::getInstance().logMessage((LogType)rec.type, rec.timestamp, msg,
+                                         rec.pFilename, rec.pFuncName, rec.lineNum);
+}
+
+void DeferredLogger::drainTask(void* pDeferredLogger)
+{
+    DeferredLogger* pLogger = (DeferredLogger*) pDeferredLogger;
+    while (1)
+    {
+        vTaskDelay(LOGGER_DEFERRED_DRAIN_MS / portTICK_RATE_MS);
+        pLogger->drain();
+    }
+}
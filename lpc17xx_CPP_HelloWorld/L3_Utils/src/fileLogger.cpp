@@ -0,0 +1,193 @@
+#include "filelogger.hpp"
+
+
+
+FileLogger::FileLogger() :
+    CSVLogger(mBuff[0], LOGGER_BUFFER_SIZE),
+    mFileOpened(false),
+    mUnsyncedData(false),
+    mSyncPolicy(syncEveryBuffer),
+    mSyncPeriodMs(1000),
+    mStalledCount(0),
+    mDroppedCount(0),
+    mBuffersWritten(0),
+    mSyncCount(0),
+    mActiveBuff(0)
+{
+#if LPC_LOGGER
+    mSemHandle = xSemaphoreCreateMutex();
+    mFlushMutex = xSemaphoreCreateMutex();
+    vSemaphoreCreateBinary(mSpareFree);
+    vSemaphoreCreateBinary(mSyncDone);
+    xSemaphoreTake(mSyncDone, 0);
+
+    // Queue needs room for one completed buffer and one sync request from flush()
+    mFlushQueue = xQueueCreate(2, sizeof(FlushRequest));
+
+    // Open the logger file and seek to end of file
+    if(FR_OK == f_open(&mOutFile, LOGGER_FILE_NAME, FA_OPEN_ALWAYS|FA_WRITE))
+    {
+        if(FR_OK == f_lseek(&mOutFile, f_size(&mOutFile)))
+        {
+            mFileOpened = true;
+        }
+    }
+    // Leave the file opened to maximize performance
+
+    mFlushTaskHandle = 0;
+    xTaskCreate(flushTask, (signed char*)"logflush", STACK_BYTES(1536), this,
+                LOGGER_FLUSH_TASK_PRIORITY, &mFlushTaskHandle);
+#endif
+}
+
+void FileLogger::flush()
+{
+#if LPC_LOGGER
+    // Without the scheduler, the buffer is written directly by handleCompletedBuffer()
+    if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState() || 0 == mFlushTaskHandle)
+    {
+        LoggerBase::flush();
+        writeBuffer(0, 0, true);
+        return;
+    }
+
+    xSemaphoreTake(mFlushMutex, portMAX_DELAY);
+    {
+        semTake();
+        LoggerBase::flush();
+        semGive();
+
+        // The sync request is queued behind the buffer, so wait until both are done
+        const FlushRequest syncRequest = { 0, 0 };
+        xQueueSend(mFlushQueue, &syncRequest, portMAX_DELAY);
+        xSemaphoreTake(mSyncDone, portMAX_DELAY);
+    }
+    xSemaphoreGive(mFlushMutex);
+#else
+    LoggerBase::flush();
+#endif
+}
+
+void FileLogger::setSyncPolicy(LoggerSyncPolicy policy, unsigned int periodMs)
+{
+    mSyncPeriodMs = (0 == periodMs) ? 1 : periodMs;
+    mSyncPolicy = policy;
+
+    // Commit the data logged with the previous policy, and wake up the flush task to use the new policy
+    flush();
+}
+
+void FileLogger::handleCompletedBuffer(char* pBuff, unsigned int size)
+{
+#if LPC_LOGGER
+    // Write directly if there is no flush task to hand the buffer to, or we are the flush task
+    if(taskSCHEDULER_RUNNING != xTaskGetSchedulerState() ||
+       0 == mFlushTaskHandle || xTaskGetCurrentTaskHandle() == mFlushTaskHandle)
+    {
+        writeBuffer(pBuff, size, syncOnFlushOnly != mSyncPolicy);
+        return;
+    }
+
+    // Wait for the spare buffer if flush task is still writing it
+    if(!xSemaphoreTake(mSpareFree, 0))
+    {
+        ++mStalledCount;
+        if(!xSemaphoreTake(mSpareFree, LOGGER_STALL_TIMEOUT_MS / portTICK_RATE_MS))
+        {
+            // Drop the data and keep using the same buffer
+            for(unsigned int i = 0; i < size; i++) {
+                if('\n' == pBuff[i]) {
+                    ++mDroppedCount;
+                }
+            }
+            return;
+        }
+    }
+
+    const FlushRequest request = { pBuff, size };
+    xQueueSend(mFlushQueue, &request, portMAX_DELAY);
+
+    mActiveBuff ^= 1;
+    setBuffer(mBuff[mActiveBuff]);
+#else
+    writeBuffer(pBuff, size, true);
+#endif
+}
+
+void FileLogger::writeBuffer(const char* pBuff, unsigned int size, bool sync)
+{
+    bool success = mFileOpened;
+#if LPC_LOGGER
+    if(mFileOpened && size > 0)
+    {
+        unsigned int bytesWritten = 0;
+        success = (FR_OK == f_write(&mOutFile, pBuff, size, &bytesWritten) && size == bytesWritten);
+        mUnsyncedData = true;
+        ++mBuffersWritten;
+    }
+    if(mFileOpened && sync && mUnsyncedData)
+    {
+        if(FR_OK != f_sync(&mOutFile)) {
+            success = false;
+        }
+        mUnsyncedData = false;
+        ++mSyncCount;
+    }
+#endif
+
+    if(!success && size > 0) {
+        puts("Error logging data to file, here is a printout of the data: ");
+        for(unsigned int i=0; i<size; i++) {
+            putchar(pBuff[i]);
+        }
+    }
+}
+
+#if LPC_LOGGER
+void FileLogger::flushTask(void* pFileLogger)
+{
+    FileLogger* pLogger = (FileLogger*) pFileLogger;
+    FlushRequest request;
+
+    while(1)
+    {
+        const portTickType timeout = (syncPeriodically == pLogger->mSyncPolicy) ?
+                                     (pLogger->mSyncPeriodMs / portTICK_RATE_MS) : portMAX_DELAY;
+
+        if(xQueueReceive(pLogger->mFlushQueue, &request, timeout))
+        {
+            pLogger->handleFlushRequest(request);
+        }
+        else
+        {
+            /**
+             * Sync period expired: Write the partially filled buffer ourselves and sync the file.
+             * If another task is logging right now, only the data written so far is synced
+             * rather than waiting for the logger (which may itself be waiting for us).
+             */
+            if(xSemaphoreTake(pLogger->mSemHandle, 0))
+            {
+                // A buffer may have been queued after the timeout, and it must be written first
+                while(xQueueReceive(pLogger->mFlushQueue, &request, 0)) {
+                    pLogger->handleFlushRequest(request);
+                }
+                pLogger->LoggerBase::flush();
+                xSemaphoreGive(pLogger->mSemHandle);
+            }
+            pLogger->writeBuffer(0, 0, true);
+        }
+    }
+}
+
+void FileLogger::handleFlushRequest(const FlushRequest& request)
+{
+    if(0 == request.pBuff) {
+        writeBuffer(0, 0, true);
+        xSemaphoreGive(mSyncDone);
+    }
+    else {
+        writeBuffer(request.pBuff, request.size, syncEveryBuffer == mSyncPolicy);
+        xSemaphoreGive(mSpareFree);
+    }
+}
+#endif
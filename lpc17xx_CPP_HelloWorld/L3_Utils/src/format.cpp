@@ -0,0 +1,134 @@
+#include "format.hpp"
+
+
+
+/**
+ * Two ASCII digits for each number from 0-99 so that decimal conversion
+ * only needs one division for every two digits.
+ */
+static const char gDigitPairs[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static const char gHexDigitsUpper[] = "0123456789ABCDEF";
+static const char gHexDigitsLower[] = "0123456789abcdef";
+
+
+
+int FormatCore::toDec(char* pOut, unsigned int value)
+{
+    // Convert from the right-most digits to the left into our temporary buffer
+    char digits[10];
+    char* p = digits + sizeof(digits);
+
+    while (value >= 100)
+    {
+        const unsigned int pairIdx = (value % 100) * 2;
+        value /= 100;
+        *--p = gDigitPairs[pairIdx + 1];
+        *--p = gDigitPairs[pairIdx];
+    }
+    if (value >= 10)
+    {
+        const unsigned int pairIdx = value * 2;
+        *--p = gDigitPairs[pairIdx + 1];
+        *--p = gDigitPairs[pairIdx];
+    }
+    else
+    {
+        *--p = '0' + value;
+    }
+
+    const int len = (digits + sizeof(digits)) - p;
+    for (int i = 0; i < len; i++) {
+        pOut[i] = p[i];
+    }
+    return len;
+}
+
+int FormatCore::toDec(char* pOut, int value)
+{
+    if (value < 0)
+    {
+        *pOut = '-';
+        return 1 + toDec(pOut + 1, 0U - (unsigned int) value);
+    }
+    return toDec(pOut, (unsigned int) value);
+}
+
+int FormatCore::toHex(char* pOut, unsigned int value, bool upperCase)
+{
+    const char* pHexDigits = upperCase ? gHexDigitsUpper : gHexDigitsLower;
+
+    // Find the number of hex digits needed
+    int len = 1;
+    while (len < 8 && (value >> (len * 4))) {
+        len++;
+    }
+
+    for (int i = len - 1; i >= 0; i--)
+    {
+        pOut[i] = pHexDigits[value & 0xF];
+        value >>= 4;
+    }
+    return len;
+}
+
+int FormatCore::toFixed(char* pOut, float value, unsigned int decimals)
+{
+    static const float floatScale[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f };
+    static const unsigned int intScale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+    const float maxValue = 4294967040.0f; // Largest float below 2^32
+    int len = 0;
+
+    if (decimals > 6) {
+        decimals = 6;
+    }
+    if (value < 0)
+    {
+        pOut[len++] = '-';
+        value = -value;
+    }
+    if (!(value < maxValue)) // Also true for NaN
+    {
+        pOut[len++] = 'o';
+        pOut[len++] = 'v';
+        pOut[len++] = 'f';
+        return len;
+    }
+
+    // Split to integer and fraction and scale the fraction to an integer with rounding
+    unsigned int intPart = (unsigned int) value;
+    unsigned int fracPart = (unsigned int) ((value - intPart) * floatScale[decimals] + 0.5f);
+    if (fracPart >= intScale[decimals])
+    {
+        fracPart -= intScale[decimals];
+        intPart++;
+    }
+
+    len += toDec(pOut + len, intPart);
+    if (decimals > 0)
+    {
+        pOut[len++] = '.';
+
+        // Zero pad the fraction to the number of decimals
+        char fracDigits[10];
+        const int fracLen = toDec(fracDigits, fracPart);
+        for (int i = fracLen; i < (int) decimals; i++) {
+            pOut[len++] = '0';
+        }
+        for (int i = 0; i < fracLen; i++) {
+            pOut[len++] = fracDigits[i];
+        }
+    }
+
+    return len;
+}
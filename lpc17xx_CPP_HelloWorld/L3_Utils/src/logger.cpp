@@ -1,7 +1,6 @@
 #include "logger.hpp"
-#include <stdlib.h>   // itoa()
-#include <stdio.h>    // sprintf()
 #include <string.h>   // strlen()
+#include "format.hpp" // Formatter
 
 
 
@@ -19,23 +18,26 @@ void LoggerBase::flush()
 }
 void LoggerBase::log(const char* pMessage)
 {
-    // while not enough room to store the message, keep flushing the buffer
-    while(mBuffUsage+strlen(pMessage) > mBuffPtrSize)
+    log(pMessage, strlen(pMessage));
+}
+void LoggerBase::log(const char* pData, unsigned int len)
+{
+    // while not enough room to store the data, keep flushing the buffer
+    while(mBuffUsage+len > mBuffPtrSize)
     {
-        const int lenOfMsg = strlen(pMessage);
-        const int availableMem = mBuffPtrSize - mBuffUsage;
-        const int lenToCopy = lenOfMsg < availableMem ? lenOfMsg : availableMem;
+        const unsigned int availableMem = mBuffPtrSize - mBuffUsage;
+        const unsigned int lenToCopy = len < availableMem ? len : availableMem;
 
-        memcpy(mpBuffPtr+mBuffUsage, pMessage, lenToCopy);
+        memcpy(mpBuffPtr+mBuffUsage, pData, lenToCopy);
         mBuffUsage += lenToCopy;
         flush();
 
-        pMessage += lenToCopy;
+        pData += lenToCopy;
+        len -= lenToCopy;
     }
 
-    const int lenOfMsg = strlen(pMessage);
-    memcpy(mpBuffPtr+mBuffUsage, pMessage, lenOfMsg);
-    mBuffUsage += lenOfMsg;
+    memcpy(mpBuffPtr+mBuffUsage, pData, len);
+    mBuffUsage += len;
 }
 
 
@@ -44,58 +46,49 @@ void LoggerBase::log(const char* pMessage)
 
 void CSVLogger::logError(const char* pMessage, const char* pFilename, const char* pFuncName, int lineNum)
 {
-    logCsvMessage("ERROR", pMessage, pFilename, pFuncName, lineNum);
+    logCsvMessage("ERROR", getTimestamp(), pMessage, pFilename, pFuncName, lineNum);
 }
 void CSVLogger::logWarning(const char* pMessage, const char* pFilename, const char* pFuncName, int lineNum)
 {
-    logCsvMessage("WARN", pMessage, pFilename, pFuncName, lineNum);
+    logCsvMessage("WARN", getTimestamp(), pMessage, pFilename, pFuncName, lineNum);
 }
 void CSVLogger::logInfo(const char* pMessage, const char* pFilename, const char* pFuncName, int lineNum)
 {
-    logCsvMessage("INFO", pMessage, pFilename, pFuncName, lineNum);
+    logCsvMessage("INFO", getTimestamp(), pMessage, pFilename, pFuncName, lineNum);
+}
+void CSVLogger::logMessage(LogType type, unsigned int timestamp, const char* pMessage,
+                           const char* pFilename, const char* pFuncName, int lineNum)
+{
+    const char* const typeStr[] = { "ERROR", "WARN", "INFO" };
+    logCsvMessage(typeStr[type], timestamp, pMessage, pFilename, pFuncName, lineNum);
 }
 
-void CSVLogger::logCsvMessage(const char* pInfoType, const char* pMessage,
+void CSVLogger::logCsvMessage(const char* pInfoType, unsigned int timestamp, const char* pMessage,
                               const char* pFilename, const char* pFuncName, int lineNum)
 {
+    // Find the back-slash or forward-slash to get filename only, not absolute or relative path
+    if(0 != pFilename) {
+        const char* pSlash = strrchr(pFilename, '/');
+        // If forward-slash not found, find back-slash
+        if(0 == pSlash) pSlash = strrchr(pFilename, '\\');
+        if(0 != pSlash) pFilename = pSlash+1;
+    }
+
     semTake();
     {
-        const char comma[] = ",";
-        const char parens[] = "()";
-        const char newline[] = "\n";
-
-        char numStr[16];
-        sprintf(numStr, "%i", getTimestamp());
-        log(numStr);
-        log(comma);
-
-        log(pInfoType);
-        log(comma);
-        log(pMessage);
-        log(comma);
-
-        // Find the back-slash or forward-slash to get filename only, not absolute or relative path
-        if(0 != pFilename) {
-            char* pSlash = strrchr(pFilename, '/');
-            // If forward-slash not found, find back-slash
-            if(0 == pSlash) pSlash = strrchr(pFilename, '\\');
-            if(0 != pSlash) pFilename = pSlash+1;
-
-            log(pFilename);
-        }
-        log(comma);
+        // Format directly into the logger buffer, NULL strings are skipped by the Formatter
+        Formatter<LogSink> csv(*this);
+        csv << timestamp << ',' << pInfoType << ',' << pMessage << ',' << pFilename << ',';
 
         if(0 != pFuncName) {
-            log(pFuncName);
-            log(parens);
+            csv << pFuncName << "()";
         }
-        log(comma);
+        csv << ',';
 
         if(0 != lineNum) {
-            sprintf(numStr, "%i", lineNum);
-            log(numStr);
+            csv << lineNum;
         }
-        log(newline);
+        csv << '\n';
     }
     semGive();
 }
@@ -10,6 +10,11 @@
 
 
 
+/// The type of a logged message
+typedef enum { LogTypeError, LogTypeWarning, LogTypeInfo } LogType;
+
+
+
 /**
  * This is the Log Buffer Base class that provides a way of logging a single message and acts like
  * a circular buffer because when the logger memory is full, a call to handleCompletedBuffer() is
@@ -45,12 +50,22 @@ class LoggerBase
          */
         void log(const char* pMessage);
 
+        /// Logs @param len bytes of @param pData in the buffer, @see log(const char*)
+        void log(const char* pData, unsigned int len);
+
         /**
          * The object inheriting this class needs to provide its way of flushing
          * the buffer when buffer becomes full or when flush() is called
          */
         virtual void handleCompletedBuffer(char* pBuff, unsigned int size)=0;
 
+        /**
+         * Switches the logger to another buffer of the same size given to the constructor.
+         * This can be called by handleCompletedBuffer() to keep logging to a new buffer
+         * while the completed buffer is being saved.
+         */
+        inline void setBuffer(char* pBuff) { mpBuffPtr = pBuff; }
+
     private:
         char* mpBuffPtr;                 ///< Memory pointer to store buffer until flush()
         const unsigned int mBuffPtrSize; ///< Size allocated for mpBuffPtr
@@ -85,6 +100,16 @@ class CSVLogger : public LoggerBase
         void logInfo   (const char* pMessage, const char* pFilename=0, const char* pFuncName=0, int lineNum=0);
         /** @} */
 
+        /**
+         * Logs a message with the given timestamp rather than the current timestamp.
+         * This is used to log messages that were recorded earlier and formatted later.
+         * @param type       The type of the message
+         * @param timestamp  The timestamp to log with the message
+         * @see logCsvMessage() for the rest of the parameters
+         */
+        void logMessage(LogType type, unsigned int timestamp, const char* pMessage,
+                        const char* pFilename=0, const char* pFuncName=0, int lineNum=0);
+
     protected:
         /**
          * Constructor
@@ -119,13 +144,28 @@ class CSVLogger : public LoggerBase
          * Logs a message separated by commas that has 6 columns:
          *  Timestamp, pInfoType, Message, File name, Function Name, Line Number
          * @param pInfoType  The type of information being logged, such as "ERROR" or "INFO"
+         * @param timestamp  The timestamp of the message
          * @param pMessage   The message to log, can be NULL pointer if no message
          * @param pFuncName  Optional parameter: The function name calling this method
          * @param pFilename  Optional parameter: The file name calling this method
          * @param lineNum    Optional parameter: The software code line number calling this method
          */
-        void logCsvMessage(const char* pInfoType, const char* pMessage,
+        void logCsvMessage(const char* pInfoType, unsigned int timestamp, const char* pMessage,
                            const char* pFilename=0, const char* pFuncName=0, int lineNum=0);
+
+        /**
+         * Sink for the Formatter that writes directly to the logger buffer, so
+         * the CSV message is formatted without any intermediate buffer.
+         */
+        class LogSink
+        {
+            public:
+                LogSink(CSVLogger& logger) : mLogger(logger) {}
+                void write(const char* pData, int len) { mLogger.log(pData, len); }
+            private:
+                CSVLogger& mLogger; ///< The logger to write to
+        };
+        friend class LogSink;
 };
 
 #endif /* LOGGER_HPP_ */
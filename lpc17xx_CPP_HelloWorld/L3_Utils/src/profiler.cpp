@@ -0,0 +1,160 @@
+#include <stdio.h>          // printf()
+#include "profiler.hpp"
+#include "LPC17xx.h"        // CoreDebug, __get_PRIMASK()
+#include "sysConfig.h"      // getCpuClock()
+
+
+
+ProfileProbe* Profiler::mpFirstProbe = 0;
+unsigned int Profiler::mOverheadCycles = 0;
+
+void ProfileProbe::record(unsigned int cycles)
+{
+    const unsigned int overhead = Profiler::getOverheadCycles();
+    cycles = (cycles > overhead) ? (cycles - overhead) : 0;
+    const unsigned int bucket = Profiler::getBucket(cycles);
+
+    if (!added) {
+        Profiler::addProbe(*this);
+    }
+
+    // Probes may be recorded by tasks and ISRs at the same time
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        ++count;
+        totalCycles += cycles;
+        if (cycles < minCycles) {
+            minCycles = cycles;
+        }
+        if (cycles > maxCycles) {
+            maxCycles = cycles;
+        }
+        ++hist[bucket];
+    }
+    __set_PRIMASK(primask);
+}
+
+void ProfileProbe::reset()
+{
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        count = 0;
+        minCycles = 0xFFFFFFFF;
+        maxCycles = 0;
+        totalCycles = 0;
+        for (unsigned int i = 0; i < PROFILER_HIST_BUCKETS; i++) {
+            hist[i] = 0;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+
+
+void Profiler::init()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    PROFILER_DWT_CYCCNT = 0;
+    PROFILER_DWT_CTRL |= (1 << 0);  // CYCCNTENA
+
+    // Measure the cycles of an empty ProfileScope (the smallest of a few tries)
+    ProfileProbe probe = PROFILE_PROBE_INITIALIZER("overhead");
+    probe.added = true;     // Do not list this probe
+    mOverheadCycles = 0;
+    for (int i = 0; i < 8; i++) {
+        ProfileScope timeThis(probe);
+    }
+    mOverheadCycles = probe.minCycles;
+}
+
+unsigned int Profiler::cyclesToUs(unsigned int cycles)
+{
+    const unsigned int cyclesPerUs = getCpuClock() / (1000 * 1000UL);
+    return (cyclesPerUs > 0) ? (cycles / cyclesPerUs) : 0;
+}
+
+void Profiler::addProbe(ProfileProbe& probe)
+{
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    {
+        // Check again in case an ISR added this probe in the meantime
+        if (!probe.added) {
+            probe.pNext = mpFirstProbe;
+            mpFirstProbe = &probe;
+            probe.added = true;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void Profiler::resetAll()
+{
+    for (ProfileProbe* p = mpFirstProbe; 0 != p; p = p->pNext) {
+        p->reset();
+    }
+}
+
+void Profiler::printAll()
+{
+    printf("%-16s %8s %10s %10s %10s %10s\n", "Probe", "Count", "Min", "Mean", "Max", "Max (us)");
+    for (ProfileProbe* p = mpFirstProbe; 0 != p; p = p->pNext)
+    {
+        // Copy the probe so its values are consistent while being printed
+        ProfileProbe s;
+        const unsigned int primask = __get_PRIMASK();
+        __disable_irq();
+        {
+            s = *p;
+        }
+        __set_PRIMASK(primask);
+
+        if (0 == s.count) {
+            printf("%-16s %8u\n", s.pName, 0);
+            continue;
+        }
+        printf("%-16s %8u %10u %10u %10u %10u\n", s.pName, s.count,
+               s.minCycles, s.getMeanCycles(), s.maxCycles, cyclesToUs(s.maxCycles));
+
+        printf("   Histogram: ");
+        for (unsigned int i = 0; i < PROFILER_HIST_BUCKETS; i++) {
+            const unsigned int limit = getBucketLimit(i);
+            if (s.hist[i] > 0) {
+                if (0 == limit) {
+                    printf("[more]%u ", s.hist[i]);
+                }
+                else {
+                    printf("[<%u]%u ", limit, s.hist[i]);
+                }
+            }
+        }
+        printf("\n");
+    }
+    printf("Timings are in CPU cycles (%u Mhz), overhead of %u cycles is excluded\n",
+            (unsigned int) (getCpuClock() / (1000 * 1000UL)), mOverheadCycles);
+}
+
+void Profiler::printDurationSince(unsigned long long startMicros)
+{
+    const unsigned long long elapsed = systime_GetMicros() - startMicros;
+    printf("   Finished in %u.%03u ms\n", (unsigned int) (elapsed / 1000), (unsigned int) (elapsed % 1000));
+}
+
+unsigned int Profiler::getBucket(unsigned int cycles)
+{
+    // Number of bits used by cycles
+    const unsigned int bits = (0 == cycles) ? 0 : (32 - __builtin_clz(cycles));
+    if (bits <= PROFILER_HIST_MIN_BITS) {
+        return 0;
+    }
+
+    const unsigned int bucket = (bits - PROFILER_HIST_MIN_BITS + 1) / 2;
+    return (bucket < PROFILER_HIST_BUCKETS) ? bucket : (PROFILER_HIST_BUCKETS - 1);
+}
+
+unsigned int Profiler::getBucketLimit(unsigned int bucket)
+{
+    return (bucket >= PROFILER_HIST_BUCKETS - 1) ? 0 : (1 << (PROFILER_HIST_MIN_BITS + 2 * bucket));
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h> // realloc()
 #include <stdio.h>  // sprintf
 #include <stdlib.h> // atoi() atof()
+#include "format.hpp"   // FormatCore
 
 
 int str::toInt(const char* pString)     {   return atoi(pString);   }
@@ -76,28 +77,31 @@ void str::toUpper()
 int str::printf(const char* pFormat, ...)
 {
     va_list args;
+    va_list argsCopy;
     va_start(args, pFormat);
+    va_copy(argsCopy, args);
 
     /**
-     * Try to print into allocated memory, and if the number of characters
-     * is greater than capacity, reallocate more memory, and print again
+     * Print into allocated memory (which has +1 for NULL), and only if the number
+     * of characters is greater than capacity, reallocate and print again.
      */
 #if STR_SUPPORT_FLOAT
-    int len = vsnprintf(mpStr, getCapacity(), pFormat, args);
+    int len = vsnprintf(mpStr, mCapacity + 1, pFormat, args);
 #else
-    int len = vsniprintf(mpStr, getCapacity(), pFormat, args);
+    int len = vsniprintf(mpStr, mCapacity + 1, pFormat, args);
 #endif
 
-    if(len <= getCapacity())
+    if(len > mCapacity)
     {
-        reserve(len);
+        reAllocateMem(len);
 #if STR_SUPPORT_FLOAT
-        len = vsnprintf(mpStr, getCapacity(), pFormat, args);
+        len = vsnprintf(mpStr, mCapacity + 1, pFormat, argsCopy);
 #else
-        len = vsniprintf(mpStr, getCapacity(), pFormat, args);
+        len = vsniprintf(mpStr, mCapacity + 1, pFormat, argsCopy);
 #endif
     }
 
+    va_end(argsCopy);
     va_end(args);
     return len;
 }
@@ -133,11 +137,18 @@ void str::append(const char* pString)
 {
     insertAtEnd(pString);
 }
+void str::append(const char* pData, int len)
+{
+    ensureMemoryToInsertNChars(len);
+
+    char* pEnd = mpStr + getLen();
+    memcpy(pEnd, pData, len);
+    pEnd[len] = '\0';
+}
 void str::append(int x)
 {
-    char intValString[32];
-    sprintf(intValString, "%i", x);
-    append(intValString);
+    char intValString[FormatCore::maxChars];
+    append(intValString, FormatCore::toDec(intValString, x));
 }
 #if STR_SUPPORT_FLOAT
 void str::append(float x)
@@ -149,9 +160,12 @@ void str::append(float x)
 #endif
 void str::appendAsHex(unsigned int num)
 {
-    char hexVal[32];
-    sprintf(hexVal, "%02X", num);
-    append(hexVal);
+    char hexVal[FormatCore::maxChars];
+    int len = FormatCore::toHex(hexVal, num);
+    if (1 == len) {
+        append("0", 1); // Minimum of 2 hex digits
+    }
+    append(hexVal, len);
 }
 
 
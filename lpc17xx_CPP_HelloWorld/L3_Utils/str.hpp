@@ -130,6 +130,7 @@ class str
          * @{ \name Append functions
          */
         void append(const char* pString);           ///< Appends constant string pointer
+        void append(const char* pData, int len);    ///< Appends len chars of pData
         void append(const str& s) { append(s()); }  ///< Appends another str
         void append(int x);                         ///< Appends integer as characters
 #if STR_SUPPORT_FLOAT
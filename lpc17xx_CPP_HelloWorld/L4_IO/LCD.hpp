@@ -14,6 +14,17 @@
 #define LCD_HPP_
 
 #include "src/io_device.hpp"  // Base class
+#include "spi1.h"               // spi1_Device
+#include "ssp0.h"               // ssp0_Device
+
+/**
+ * Set to 1 to connect the LCD to SSP0 rather than SPI1, so LCD updates don't wait
+ * for the SD Card and Flash Memory transfers on SPI1 (see ssp0.h for the pins).
+ */
+#define LCD_USE_SSP0        0
+#define LCD_SPI_CLOCK_KHZ   50  ///< SPI clock used for the LCD
+#define LCD_SPI_MODE        3   ///< SPI mode 3: CPOL = 1, CPHA = 1
+#define LCD_CS_SIGNAL       (1 << 15)   ///< LCD chip-select at P0.15
 
 class LCD :public IO_Device, public SingletonTemplate<LCD>
 {
@@ -30,7 +41,14 @@ class LCD :public IO_Device, public SingletonTemplate<LCD>
         void write(const char* words);//writes starting from home position
 
     private:
-        LCD() {}   ///< Private constructor of this Singleton class
+        LCD();     ///< Private constructor of this Singleton class
+
+        void select();      ///< Acquires the SPI bus with the LCD's profile and selects the LCD
+        void deselect();    ///< De-selects the LCD and releases the SPI bus
+        char exchangeByte(char out);                              ///< Exchanges a byte with the LCD
+        void transfer(const unsigned char* pData, unsigned int len); ///< Sends bytes to the LCD
+
+        spi1_Device mSpiDevice;   ///< SPI bus profile of the LCD
         friend class SingletonTemplate<LCD>;  ///< Friend class used for Singleton Template
 };
 #endif /* LCD_HPP_ */
@@ -36,12 +36,22 @@ class LED_Display : public IO_Device, public I2C_Device_Base, public SingletonTe
         void setRightDigit(char alpha);
         /** @} */
 
+        /**
+         * Sets both alpha-numeric displays using a single I2C transaction
+         * @param left  The alpha to set on the left display
+         * @param right The alpha to set on the right display
+         */
+        void setDigits(char left, char right);
+
         /// @returns the characters currently displayed on this LED Display
         const char* getValueAsString();
 
     private:
         char mNumAtDisplay[2]; ///< The number currently being displayed
 
+        /// Sets the digit at the index of mNumAtDisplay in the shadow register without writing it
+        void setDigit(unsigned int index, char alpha);
+
         /// Private constructor of this Singleton class
         LED_Display() : I2C_Device_Base(Address_LED_Display)
         {
@@ -25,6 +25,13 @@ class Acceleration_Sensor : public IO_Device, public I2C_Device_Base, public Sin
         short getY();  ///< @returns Y-Axis value
         short getZ();  ///< @returns Z-Axis value
 
+        /**
+         * Reads all three axis in a single I2C transaction, which is faster than
+         * calling getX(), getY() and getZ() and the values are from the same sample.
+         * @returns true if the values were read successfully
+         */
+        bool getXYZ(short& x, short& y, short& z);
+
         const char* getValueAsString(); ///< @returns string containg X : Y : Z values
 
     private:
@@ -4,30 +4,31 @@
 
 
 
-static xSemaphoreHandle *pSpiSemaphore = 0;
-void diskio_initializeSPIMutex(xSemaphoreHandle *pSemaphore)  {   pSpiSemaphore = pSemaphore;      }
+/// @returns the SPI bus profile of the drive @param drv
+static const spi1_Device* diskio_getSpiDevice(BYTE drv)
+{
+    return (flashDriveNum == drv) ? flash_GetSpiDevice() : sd_GetSpiDevice();
+}
 
 /**
  * A very smart, but (slightly) ugly macro, but saves us lots of duplicate code.
- * The benefits of this macro outweigh the negatives because this macro will obtain
- * the semaphore only when FreeRTOS is started, and give it back as well.
- * If FreeRTOS is not started, this will not make the FreeRTOS API call at all.
+ * The benefits of this macro outweigh the negatives because this macro will acquire
+ * the SPI bus with the profile of the drive, and release it as well.
+ * spi1_Acquire() only uses the SPI mutex if FreeRTOS is started.
  *
  * @warning DO NOT USE RETURN statement in this section otherwise it will break it!!
  */
-#define MUTEX_SECTION() \
-    for(char rtosStarted = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()),         \
-                lock = rtosStarted ? xSemaphoreTake(*pSpiSemaphore, portMAX_DELAY) : 1; \
+#define MUTEX_SECTION(drv) \
+    for(char lock = (spi1_Acquire(diskio_getSpiDevice(drv)), 1); \
                 0 != lock; \
-                lock = rtosStarted ? !xSemaphoreGive(*pSpiSemaphore) : 0)
-                /* If xSemaphoreGive() returns true, convert to false on purpose to quit loop */
+                lock = (spi1_Release(), 0))
 
 
 DSTATUS disk_initialize(BYTE drv)
 {
     DSTATUS status = RES_PARERR;
 
-    MUTEX_SECTION()
+    MUTEX_SECTION(drv)
     {
         switch(drv)
         {
@@ -44,7 +45,7 @@ DSTATUS disk_status(BYTE drv)
 {
     DSTATUS status = RES_PARERR;
 
-    MUTEX_SECTION()
+    MUTEX_SECTION(drv)
     {
         switch(drv)
         {
@@ -62,7 +63,7 @@ DRESULT disk_read (BYTE drv,       BYTE *buff, DWORD sector, BYTE count)
 {
     DSTATUS status = RES_PARERR;
 
-    MUTEX_SECTION()
+    MUTEX_SECTION(drv)
     {
         switch(drv)
         {
@@ -79,7 +80,7 @@ DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
 {
     DSTATUS status = RES_PARERR;
 
-    MUTEX_SECTION()
+    MUTEX_SECTION(drv)
     {
         switch(drv)
         {
@@ -96,7 +97,7 @@ DRESULT disk_ioctl(BYTE drv, BYTE ctrl,void *buff)
 {
     DSTATUS status = RES_PARERR;
 
-    MUTEX_SECTION()
+    MUTEX_SECTION(drv)
     {
         switch(drv)
         {
@@ -7,9 +7,6 @@ extern "C" {
 
 #include "disk_defines.h"
 #include "diskioStructs.h"  // DSTATUS
-#include "FreeRTOS.h"
-#include "task.h"           // xTaskGetSchedulerState()
-#include "semphr.h"         // SPI-Access Semaphore
 
 /// Enumeration of the Drive numbers :
 typedef enum {
@@ -18,13 +15,6 @@ typedef enum {
 } DriveNumberType;
 
 
-/**
- * Initializes the Mutex to use for SPI Flash and SPI SD Card Access
- * @param pSemaphore    The pointer to the semaphore to use
- * @warning If a mutex is not set and FreeRTOS is started, then diskio layer will crash.
- */
-void diskio_initializeSPIMutex(xSemaphoreHandle *pSemaphore);
-
 /**
  * Initializes the disk given by @param drv
  */
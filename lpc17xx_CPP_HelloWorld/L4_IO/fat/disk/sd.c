@@ -50,6 +50,7 @@
 volatile DSTATUS Stat = STA_NOINIT; /* Disk status */
 volatile BYTE SD_TIMER1_100HZ, SD_TIMER2_100HZ; 		/* 100Hz decrement timers */
 BYTE CardType;						/* Card type flags */
+spi1_Device gSdSpiDevice;			/* SPI bus profile used by FCLK_SLOW() and FCLK_FAST() */
 
 char get_spi(void)       { SELECT(); return 1;               }
 char release_spi(void)   { DESELECT(); rcvr_spi(); return 1; }
@@ -71,6 +72,12 @@ void sd_initializeCardSignals(void)
 {
 	SET_CSPIN_OUT(); // Set the CS pin of SD card as output and deselect
 	CARD_SIGNAL_INIT(); // Set the write-protect and card-detect signals as input
+	spi1_InitDevice(&gSdSpiDevice, SD_SPI_SLOW_KHZ, SD_SPI_MODE, LPC_GPIO0, SPI_SD_CS);
+}
+
+const spi1_Device* sd_GetSpiDevice(void)
+{
+	return &gSdSpiDevice;
 }
 
 void power_on(void)
@@ -195,15 +202,20 @@ DWORD arg /* Argument */
 	}
 
 	/* Send command packet */
-	xmit_spi(cmd) ; 				/* Start + Command index */
-	xmit_spi((BYTE)(arg >> 24)) ;	/* Argument[31..24] */
-	xmit_spi((BYTE)(arg >> 16)) ;	/* Argument[23..16] */
-	xmit_spi((BYTE)(arg >> 8))  ;	/* Argument[15..8] */
-	xmit_spi((BYTE)arg) ; 			/* Argument[7..0] */
 	n = 0x01; /* Dummy CRC + Stop */
 	if (cmd == CMD0) n = 0x95; /* Valid CRC for CMD0(0) */
 	if (cmd == CMD8) n = 0x87; /* Valid CRC for CMD8(0x1AA) */
-	xmit_spi(n);
+	{
+		const BYTE packet[6] = {
+			cmd,				/* Start + Command index */
+			(BYTE)(arg >> 24),	/* Argument[31..24] */
+			(BYTE)(arg >> 16),	/* Argument[23..16] */
+			(BYTE)(arg >> 8),	/* Argument[15..8] */
+			(BYTE)arg,			/* Argument[7..0] */
+			n					/* CRC + Stop */
+		};
+		spi1_Transfer(packet, 0, sizeof(packet));
+	}
 
 	/* Receive command response */
 	if (cmd == CMD12) rcvr_spi(); /* Skip a stuff byte when stop reading */
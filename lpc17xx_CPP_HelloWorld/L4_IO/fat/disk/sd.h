@@ -14,6 +14,7 @@ extern "C" {
 
 
 void sd_initializeCardSignals(void); ///< Initializes the SD Card Signals using CARD_SIGNAL_INIT() and SET_CSPIN_OUT()
+const spi1_Device* sd_GetSpiDevice(void); ///< @returns the SPI bus profile of the SD Card
 DSTATUS sd_initialize();             ///< Initializes the SD Card for SPI Mode, called automatically by disk_initialize()
 DSTATUS sd_status();                 ///< Returns status of card (if its been initialized or not)
 
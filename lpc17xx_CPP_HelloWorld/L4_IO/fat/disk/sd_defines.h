@@ -27,8 +27,12 @@
 							LPC_GPIO0->FIODIR &= ~SOCKWP;       \
 							LPC_GPIO0->FIODIR &= ~SOCKINS;
 
-#define	FCLK_SLOW()			spi1_SetMaxClockMhz(1)  /* Set slow SPI clock (100k-400k) */
-#define	FCLK_FAST()			spi1_SetMaxClockMhz(24) /* Set fast SPI clock (depends on the CSD) */
+#define SD_SPI_SLOW_KHZ		1000	/* Slow SPI clock used to initialize the card */
+#define SD_SPI_FAST_KHZ		24000	/* SD Card specifications are 24Mhz maximum */
+#define SD_SPI_MODE			0		/* SPI mode 0: CPOL = 0, CPHA = 0 */
+
+#define	FCLK_SLOW()			spi1_SetDeviceClock(&gSdSpiDevice, SD_SPI_SLOW_KHZ) /* Set slow SPI clock (100k-400k) */
+#define	FCLK_FAST()			spi1_SetDeviceClock(&gSdSpiDevice, SD_SPI_FAST_KHZ) /* Set fast SPI clock (depends on the CSD) */
 
 #define xmit_spi(dat)		spi1_ExchangeByte(dat)
 #define rcvr_spi()			spi1_ExchangeByte(0xff)
@@ -7,6 +7,10 @@
 
 /// The GPIO Pin number of the Flash Memory's chip-select (CS) signal
 #define FLASH_CS_SIGNAL      (1 << 16)
+#define FLASH_SPI_KHZ        24000      ///< SPI clock used for the Flash Memory
+#define FLASH_SPI_MODE       0          ///< SPI mode 0: CPOL = 0, CPHA = 0
+
+static spi1_Device mFlashSpiDevice;     ///< SPI bus profile of the Flash Memory
 
 inline void flashDeselect()
 {
@@ -29,6 +33,11 @@ void flash_InitializeSignals()
     LPC_PINCON->PINSEL1 &= ~(3 << 0);
     LPC_GPIO0->FIODIR |= FLASH_CS_SIGNAL;
     flashDeselect();
+    spi1_InitDevice(&mFlashSpiDevice, FLASH_SPI_KHZ, FLASH_SPI_MODE, LPC_GPIO0, FLASH_CS_SIGNAL);
+}
+const spi1_Device* flash_GetSpiDevice()
+{
+    return &mFlashSpiDevice;
 }
 inline char spiExchangeByte(char b)
 {
@@ -89,10 +98,8 @@ typedef union
     static void flash_WritePage(const unsigned char* pData, const FlashAddressType addr);
     inline void flash_SendOpCodeAndAddr(const FlashOpCodeType opcode, const FlashAddressType addr)
     {
-        spiExchangeByte(opcode);
-        spiExchangeByte(addr.byte.B23_B16);
-        spiExchangeByte(addr.byte.B15_B08);
-        spiExchangeByte(addr.byte.B07_B00);
+        const unsigned char cmd[] = { opcode, addr.byte.B23_B16, addr.byte.B15_B08, addr.byte.B07_B00 };
+        spi1_Transfer(cmd, 0, sizeof(cmd));
     }
 /** @} */
 
@@ -145,16 +152,12 @@ DRESULT flash_ReadSector(unsigned char* pData, int sectorNum, int sectorCount)
 {
     FlashAddressType addr;
     addr.fullAddr = (sectorNum * FLASH_SECTOR_SIZE);
-    const unsigned char dummyByte = 0xFF;
 
     waitUntilNotBusy();
     CHIP_SELECT_OP()
     {
         flash_SendOpCodeAndAddr(opCode_readContinousMemRead, addr);
-        spiExchangeByte(dummyByte);
-        spiExchangeByte(dummyByte);
-        spiExchangeByte(dummyByte);
-        spiExchangeByte(dummyByte);
+        spi1_Transfer(0, 0, 4);     // 4 dummy bytes
 
         for(int i = 0; i < sectorCount; i++) {
             spi1_Receive256Bytes(pData);
@@ -10,6 +10,7 @@
 #endif
 
 #include "diskioStructs.h" // Used in flash_ioctl()
+#include "spi1.h"          // spi1_Device
 
 
 
@@ -27,6 +28,11 @@
  */
 void flash_InitializeSignals();
 
+/**
+ * @returns the SPI bus profile (clock, mode and chip-select) of this Flash Memory
+ */
+const spi1_Device* flash_GetSpiDevice();
+
 /**
  * Reads a sector from the Flash Memory
  * @param pData The pointer to the data to save the read
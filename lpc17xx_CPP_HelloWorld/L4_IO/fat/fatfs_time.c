@@ -1,19 +1,12 @@
 #include "integer.h"    // DWORD
-#include "rtc.h"        // RTC functions
+#include "systime.h"    // systime_GetFatTime()
 
 /**
  * This function is called by FAT FS System to get system time
+ * The time is cached by the time service once per second, so the RTC is not read here.
  * @return DWORD containing the time structure
  */
 DWORD get_fattime()
 {
-    RTC sysTime;
-    rtc_gettime(&sysTime);
-
-    return ((DWORD) (sysTime.year - 1980) << 25)
-            | ((DWORD) sysTime.month << 21)
-            | ((DWORD) sysTime.day << 16)
-            | ((DWORD) sysTime.hour << 11)
-            | ((DWORD) sysTime.min << 5)
-            | ((DWORD) sysTime.sec >> 1);
+    return systime_GetFatTime();
 }
@@ -4,7 +4,16 @@
 #ifndef I2C_DEVICE_BASE_HPP_
 #define I2C_DEVICE_BASE_HPP_
 
+#include <string.h>     // memcpy()
 #include "I2C2.hpp"
+#include "FreeRTOS.h"
+#include "task.h"       // xTaskGetSchedulerState()
+#include "semphr.h"     // Recursive mutex of the shadow registers
+
+
+
+/// Maximum number of registers an I2C device can keep in its shadow register map
+#define I2C_DEVICE_SHADOW_REGS      16
 
 
 
@@ -14,28 +23,244 @@
  * more easily as this class will puts an abstraction layer on I2C and provides simple
  * functionality to read and write registers over I2C Bus.
  *
+ * A device can optionally keep a shadow copy of a window of its registers that do not
+ * change by themselves, such as configuration and output registers by calling
+ * setShadowWindow().  Registers in this window are only read from the device once, and
+ * after that, they are read from RAM.  Registers can be changed in RAM using setReg(),
+ * and flushRegs() writes the changed (dirty) registers to the device using a single
+ * burst transaction for each group of contiguous dirty registers.
+ *
+ * The shadow registers are guarded by a recursive mutex of the device, and lockRegs()
+ * can be used to group a few setReg() calls with flushRegs() so that another task
+ * cannot change or flush the shadow registers in between.
+ *
+ * @code
+ *  setShadowWindow(outputPort0, 2);
+ *  lockRegs();
+ *  setReg(outputPort0, 0x12);
+ *  setReg(outputPort1, 0x34);
+ *  flushRegs();    // Writes both registers in one I2C transaction
+ *  unlockRegs();
+ * @endcode
+ *
  * @ingroup BoardIO
  */
 class I2C_Device_Base
 {
 protected:
-    /// Constructor of this base class that takes addr as a parameter
-    I2C_Device_Base(unsigned char addr) : mI2C(I2C2::getInstance()), mOurAddr(addr)
+    /**
+     * Constructor of this base class
+     * @param addr  The I2C address of this device
+     * @param bus   The I2C bus this device is connected to (I2C2 by default)
+     */
+    I2C_Device_Base(unsigned char addr, I2C_Base& bus=I2C2::getInstance()) : mI2C(bus), mOurAddr(addr),
+        mShadowFirstReg(0), mShadowNumRegs(0), mShadowValid(0), mShadowDirty(0)
     {
+        mRegMutex = xSemaphoreCreateRecursiveMutex();
     }
 
-    /// @returns the register content of this device
+    /**
+     * @{ \name Locks the shadow registers of this device for the calling task.
+     * The lock is recursive, so it can be held while calling the other functions of this class.
+     * Locking is skipped before the scheduler starts since there is only one caller.
+     */
+    inline void lockRegs()
+    {
+        if(0 != mRegMutex && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+            xSemaphoreTakeRecursive(mRegMutex, portMAX_DELAY);
+        }
+    }
+    inline void unlockRegs()
+    {
+        if(0 != mRegMutex && taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+            xSemaphoreGiveRecursive(mRegMutex);
+        }
+    }
+    /** @} */
+
+    /**
+     * @returns the register content of this device.
+     * If the register is in the shadow window, it is only read from the device once.
+     */
     inline unsigned char readReg(unsigned char reg)
     {
-        return mI2C.readReg(mOurAddr, reg);
+        if(!isShadowed(reg)) {
+            return mI2C.readReg(mOurAddr, reg);
+        }
+
+        lockRegs();
+        const unsigned short bit = shadowBit(reg);
+        char data = mShadow[reg - mShadowFirstReg];
+        if(!(mShadowValid & bit))
+        {
+            // Only cache the register if it was read successfully
+            data = 0;
+            if(mI2C.readRegisters(mOurAddr, reg, &data, 1)) {
+                mShadow[reg - mShadowFirstReg] = data;
+                mShadowValid |= bit;
+            }
+        }
+        unlockRegs();
+
+        return (unsigned char) data;
     }
 
-    /// Writes a register of this device
+    /**
+     * Writes a register of this device right away.
+     * If the register is in the shadow window, its shadow copy is updated too.
+     */
     inline void writeReg(unsigned char reg, unsigned char data)
     {
-        mI2C.writeReg(mOurAddr, reg, data);
+        const char byte = data;
+        writeRegisters(reg, &byte, 1);
+    }
+
+    /**
+     * @{ \name Shadow register functions
+     * Sets the window of registers to keep a shadow copy of.  Only registers that do not
+     * change by themselves should be in this window, such as configuration registers.
+     * @param firstReg  The first register of the window
+     * @param numRegs   The number of registers (up to I2C_DEVICE_SHADOW_REGS)
+     * @returns true if successful
+     */
+    bool setShadowWindow(unsigned char firstReg, unsigned char numRegs)
+    {
+        if(numRegs > I2C_DEVICE_SHADOW_REGS) {
+            return false;
+        }
+        lockRegs();
+        mShadowFirstReg = firstReg;
+        mShadowNumRegs = numRegs;
+        mShadowValid = mShadowDirty = 0;
+        unlockRegs();
+        return true;
+    }
+
+    /**
+     * Changes a shadowed register in RAM without writing it to the device.
+     * The register is written to the device by flushRegs().  A register that is
+     * not in the shadow window is written to the device right away.
+     */
+    inline void setReg(unsigned char reg, unsigned char data)
+    {
+        if(!isShadowed(reg)) {
+            mI2C.writeReg(mOurAddr, reg, data);
+            return;
+        }
+
+        lockRegs();
+        const unsigned short bit = shadowBit(reg);
+        mShadow[reg - mShadowFirstReg] = data;
+        mShadowValid |= bit;
+        mShadowDirty |= bit;
+        unlockRegs();
     }
 
+    /**
+     * Writes all of the dirty shadow registers to the device.  Each group of contiguous
+     * dirty registers is written using a single burst transaction.
+     * @returns true if successful, registers that failed to be written remain dirty
+     */
+    bool flushRegs()
+    {
+        bool success = true;
+        unsigned char i = 0;
+
+        lockRegs();
+        while(i < mShadowNumRegs)
+        {
+            if(!(mShadowDirty & (1 << i))) {
+                i++;
+                continue;
+            }
+
+            // Find the contiguous dirty registers starting at i
+            unsigned char len = 1;
+            while((i + len) < mShadowNumRegs && (mShadowDirty & (1 << (i + len)))) {
+                len++;
+            }
+
+            if(mI2C.writeRegisters(mOurAddr, mShadowFirstReg + i, &mShadow[i], len)) {
+                mShadowDirty &= ~(((1 << len) - 1) << i);
+            }
+            else {
+                success = false;
+            }
+            i += len;
+        }
+        unlockRegs();
+
+        return success;
+    }
+
+    /// Forgets the shadow copy so registers are read again from the device (dirty registers are discarded)
+    inline void invalidateShadow()
+    {
+        lockRegs();
+        mShadowValid = mShadowDirty = 0;
+        unlockRegs();
+    }
+    /** @} */
+
+    /**
+     * @{ \name Burst functions to read or write multiple registers in one I2C transaction
+     * @param firstReg  The first register, which auto-increments after each byte
+     * @param pData     The data to read or write
+     * @param len       The number of registers to read or write
+     * @returns true if successful
+     */
+    inline bool readRegisters(unsigned char firstReg, char* pData, unsigned int len)
+    {
+        // Serve the data from shadow registers if all of them are valid
+        if(len > 0 && isShadowed(firstReg) && isShadowed(firstReg + len - 1))
+        {
+            bool served = false;
+            const unsigned short bits = ((1 << len) - 1) << (firstReg - mShadowFirstReg);
+            lockRegs();
+            if(bits == (mShadowValid & bits)) {
+                memcpy(pData, &mShadow[firstReg - mShadowFirstReg], len);
+                served = true;
+            }
+            unlockRegs();
+
+            if(served) {
+                return true;
+            }
+        }
+        return mI2C.readRegisters(mOurAddr, firstReg, pData, len);
+    }
+    /// The shadow copy of the written registers is updated, so flushRegs() will not revert them
+    inline bool writeRegisters(unsigned char firstReg, const char* pData, unsigned int len)
+    {
+        lockRegs();
+        const bool success = mI2C.writeRegisters(mOurAddr, firstReg, pData, len);
+        updateShadow(firstReg, pData, len, success);
+        unlockRegs();
+
+        return success;
+    }
+    /** @} */
+
+    /**
+     * @{ \name Asynchronous burst functions that queue the transaction and return immediately
+     * @see I2C_Base::readAsync() for the parameters
+     */
+    inline void readRegistersAsync(I2C_Transaction& t, unsigned char firstReg, char* pData, unsigned int len,
+                                   I2C_CallbackType callback=0, void* pArg=0, xSemaphoreHandle doneSignal=0)
+    {
+        mI2C.readAsync(t, mOurAddr, firstReg, pData, len, callback, pArg, doneSignal);
+    }
+    /// The written registers are dropped from the shadow copy, so they are read again from the device
+    inline void writeRegistersAsync(I2C_Transaction& t, unsigned char firstReg, const char* pData, unsigned int len,
+                                    I2C_CallbackType callback=0, void* pArg=0, xSemaphoreHandle doneSignal=0)
+    {
+        lockRegs();
+        updateShadow(firstReg, pData, len, false);
+        unlockRegs();
+        mI2C.writeAsync(t, mOurAddr, firstReg, pData, len, callback, pArg, doneSignal);
+    }
+    /** @} */
+
     /// @returns true if the device responds to its address
     inline bool checkDeviceResponse()
     {
@@ -56,8 +281,53 @@ protected:
     }
 
 private:
+    /// @returns true if the register is in the shadow window
+    inline bool isShadowed(unsigned int reg) const
+    {
+        return (reg >= mShadowFirstReg && reg < (unsigned int)(mShadowFirstReg + mShadowNumRegs));
+    }
+
+    /// @returns the bit-mask of the shadow register
+    inline unsigned short shadowBit(unsigned char reg) const
+    {
+        return (1 << (reg - mShadowFirstReg));
+    }
+
+    /**
+     * Updates the shadow copy of registers written directly to the device (registers must be locked).
+     * If the write was not successful (or is not yet done), the shadow copy of the registers is
+     * dropped since the device content is not known.  Either way, they are no longer dirty.
+     */
+    void updateShadow(unsigned char firstReg, const char* pData, unsigned int len, bool written)
+    {
+        for(unsigned int i = 0; i < len; i++)
+        {
+            const unsigned int reg = firstReg + i;
+            if(!isShadowed(reg)) {
+                continue;
+            }
+
+            const unsigned short bit = shadowBit(reg);
+            mShadowDirty &= ~bit;
+            if(written) {
+                mShadow[reg - mShadowFirstReg] = pData[i];
+                mShadowValid |= bit;
+            }
+            else {
+                mShadowValid &= ~bit;
+            }
+        }
+    }
+
     I2C_Base& mI2C; /// Instance of I2C Bus used for communication
     const unsigned char mOurAddr; ///< I2C Address of this device
+
+    char mShadow[I2C_DEVICE_SHADOW_REGS]; ///< Shadow copy of the registers
+    unsigned char mShadowFirstReg;  ///< The first register in the shadow window
+    unsigned char mShadowNumRegs;   ///< The number of registers in the shadow window
+    unsigned short mShadowValid;    ///< Bit-mask of shadow registers that hold the device's value
+    unsigned short mShadowDirty;    ///< Bit-mask of shadow registers not yet written to the device
+    xSemaphoreHandle mRegMutex;     ///< Recursive mutex that guards the shadow registers
 };
 
 #endif /* I2C_DEVICE_BASE_HPP_ */
@@ -3,6 +3,7 @@
 #include "adc0.h"
 #include "utilities.h"
 #include "spi1.h"
+#include "filelogger.hpp"   // LOG_ERROR_FROM_ISR()
 //#include <stdio.h>  // Debugging
 //#include "utilities.h"
 
@@ -53,6 +54,8 @@ bool Acceleration_Sensor::init()
 {
     const unsigned char activeModeWith100Hz = (1 << 0) | (3 << 3); // Active Mode @ 100Hz
 
+    // Control and offset registers only change when we write them
+    setShadowWindow(Ctrl_Reg1, OffsetZ - Ctrl_Reg1 + 1);
     writeReg(Ctrl_Reg1, activeModeWith100Hz);
     const char whoAmIReg = readReg(WhoAmI);
 
@@ -70,9 +73,23 @@ short Acceleration_Sensor::getZ()
 {
     return (short)get16BitRegister(Z_MSB) / 16;
 }
+bool Acceleration_Sensor::getXYZ(short& x, short& y, short& z)
+{
+    // Read X, Y, and Z MSB and LSB registers in one burst
+    char buff[6] = {0};
+    const bool success = readRegisters(X_MSB, &buff[0], sizeof(buff));
+
+    // Data is left justified 12-bit value (MSB first)
+    x = (short)((buff[0] << 8) | (buff[1] & 0xFF)) / 16;
+    y = (short)((buff[2] << 8) | (buff[3] & 0xFF)) / 16;
+    z = (short)((buff[4] << 8) | (buff[5] & 0xFF)) / 16;
+    return success;
+}
 const char* Acceleration_Sensor::getValueAsString()
 {
-    mStr.printf("%5i:%5i:%5i", getX(), getY(), getZ());
+    short x = 0, y = 0, z = 0;
+    getXYZ(x, y, z);
+    mStr.printf("%5i:%5i:%5i", x, y, z);
     return mStr();
 }
 
@@ -150,7 +167,10 @@ extern "C"
         }
         else
         {
-            // Log error of unexpected interrupt
+            // Log error of unexpected interrupt, and clear it so we don't keep re-entering
+            const unsigned int unexpectedIntr = LPC_TIM1->IR;
+            LOG_ERROR_FROM_ISR("Unexpected Timer1 interrupt: 0x%X", unexpectedIntr);
+            LPC_TIM1->IR = unexpectedIntr;
         }
     }
 }
@@ -205,12 +225,17 @@ bool LED_Display::init()
     bool devicePresent = checkDeviceResponse();
     if(devicePresent)
     {
+        // Output, polarity and config registers only change when we write them
+        setShadowWindow(outputPort0, cfgPort1 - outputPort0 + 1);
+
         const unsigned char cfgAsOutput = 0x00;
-        writeReg(cfgPort0, cfgAsOutput);
-        writeReg(cfgPort1, cfgAsOutput);
+        lockRegs();
+        setReg(cfgPort0, cfgAsOutput);
+        setReg(cfgPort1, cfgAsOutput);
+        flushRegs();
+        unlockRegs();
 
-        setLeftDigit('.');
-        setRightDigit('.');
+        setDigits('.', '.');
     }
 
     return devicePresent;
@@ -218,22 +243,36 @@ bool LED_Display::init()
 void LED_Display::setNumber(char num)
 {
     num %= 100;
-    setRightDigit(num%10 + '0');
-
-    if(num < 10)
-        setLeftDigit(' ');
-    else
-        setLeftDigit (num/10 + '0');
+    setDigits((num < 10) ? ' ' : (num/10 + '0'), num%10 + '0');
 }
 void LED_Display::setLeftDigit(char alpha)
 {
-    mNumAtDisplay[0] = alpha;
-    writeReg(outputPort1, LED_DISPLAY_CHARMAP[(unsigned)alpha]);
+    lockRegs();
+    setDigit(0, alpha);
+    flushRegs();
+    unlockRegs();
 }
 void LED_Display::setRightDigit(char alpha)
 {
-    mNumAtDisplay[1] = alpha;
-    writeReg(outputPort0, LED_DISPLAY_CHARMAP[(unsigned)alpha]);
+    lockRegs();
+    setDigit(1, alpha);
+    flushRegs();
+    unlockRegs();
+}
+void LED_Display::setDigits(char left, char right)
+{
+    // Both digits are written in one transaction
+    lockRegs();
+    setDigit(0, left);
+    setDigit(1, right);
+    flushRegs();
+    unlockRegs();
+}
+void LED_Display::setDigit(unsigned int index, char alpha)
+{
+    // Left digit is at outputPort1, and right digit is at outputPort0
+    mNumAtDisplay[index] = alpha;
+    setReg((0 == index) ? outputPort1 : outputPort0, LED_DISPLAY_CHARMAP[(unsigned)alpha]);
 }
 const char* LED_Display::getValueAsString()
 {
@@ -302,6 +341,14 @@ bool Light_Sensor::init()
 
     adc0_initialize();
 
+    /**
+     * Sample the sensor continuously so readings never wait for the ADC.
+     * 16 conversions are averaged into each of the 100 readings per second,
+     * and the readings are smoothed by an IIR filter to reduce the noise.
+     */
+    adc0_StartTriggered(adc0_GetTriggeredChannels() | (1 << mAdcChannelOfSensor), 100, 16);
+    adc0_SetFilter(mAdcChannelOfSensor, adc0_FilterIir, 2);
+
     return true;
 }
 unsigned short Light_Sensor::getLightReading()
@@ -521,19 +568,35 @@ bool Keypad::getVal(int* button)
     return mStr();
 }*/
 //////////////////////////////////////////////////////////////////////////////
+LCD::LCD()
+{
+#if LCD_USE_SSP0
+    ssp0_Init();
+    ssp0_InitDevice(&mSpiDevice, LCD_SPI_CLOCK_KHZ, LCD_SPI_MODE, LPC_GPIO0, LCD_CS_SIGNAL);
+#else
+    spi1_InitDevice(&mSpiDevice, LCD_SPI_CLOCK_KHZ, LCD_SPI_MODE, LPC_GPIO0, LCD_CS_SIGNAL);
+#endif
+}
+#if LCD_USE_SSP0
+void LCD::select()          { ssp0_Acquire(&mSpiDevice); ssp0_Deselect(&mSpiDevice); ssp0_Select(&mSpiDevice); }
+void LCD::deselect()        { ssp0_Deselect(&mSpiDevice); ssp0_Release(); }
+char LCD::exchangeByte(char out)                                { return ssp0_ExchangeByte(out); }
+void LCD::transfer(const unsigned char* pData, unsigned int len) { ssp0_Transfer(pData, 0, len); }
+#else
+void LCD::select()          { spi1_Acquire(&mSpiDevice); spi1_Deselect(&mSpiDevice); spi1_Select(&mSpiDevice); }
+void LCD::deselect()        { spi1_Deselect(&mSpiDevice); spi1_Release(); }
+char LCD::exchangeByte(char out)                                { return spi1_ExchangeByte(out); }
+void LCD::transfer(const unsigned char* pData, unsigned int len) { spi1_Transfer(pData, 0, len); }
+#endif
 bool LCD::init()//CHECKED
 {
     /*Pre:  none
-     *Present: sets memory to write to spi1
-     *Post: true is returned once memory is set.
+     *Present: sets CS pin to output
+     *Post: true is returned once pin is set.
+     * The SPI clock and mode of the LCD are applied by select()
+     * so the SPI does not need to be initialized again.
      */
-    spi1_Init();    //initialize the MCU to use SPI
-    //set clock to 100kHz = (48Mhz)/(192*[4+1])
-    LPC_SSP1->CPSR = 194;    //CPSR =  192
-    LPC_SSP1->CR0 |= (1<<10);//SCR = 4
-    LPC_GPIO0->FIODIR |= (1<<15); //Set p0.15 GPIO to output
-    LPC_SSP1->CR0 |= (1<<6); //set CPOL = 1
-    LPC_SSP1->CR0 |= (1<<7); //set CPHA = 1
+    LPC_GPIO0->FIODIR |= LCD_CS_SIGNAL; //Set p0.15 GPIO to output
     return true;
 }
 void LCD::setup(unsigned int brightness, unsigned int contrast, bool on)
@@ -548,27 +611,27 @@ void LCD::setup(unsigned int brightness, unsigned int contrast, bool on)
      * Post: screen is setup.
      */
     //begin write to spi
-    LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+    select();
     //turn on or off
-    spi1_ExchangeByte(0xFE);
+    exchangeByte(0xFE);
     if(on)
-        spi1_ExchangeByte(0x41);
+        exchangeByte(0x41);
     else
-        spi1_ExchangeByte(0x42);
+        exchangeByte(0x42);
 
     //set contrast
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x52);
-    spi1_ExchangeByte(contrast);
+    exchangeByte(0xFE); exchangeByte(0x52);
+    exchangeByte(contrast);
     //setblack light
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x53);
-    spi1_ExchangeByte(brightness);
+    exchangeByte(0xFE); exchangeByte(0x53);
+    exchangeByte(brightness);
     //set blinking coursor
-    //spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x4B);
+    //exchangeByte(0xFE); exchangeByte(0x4B);
 	//clear screen, set coursor to home
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x51);
+    exchangeByte(0xFE); exchangeByte(0x51);
     delay_ms(2);
     //end write to spi
-    LPC_GPIO0->FIOSET|= (1<<15);
+    deselect();
 }
 void LCD::on()  //CHECKED turns on screen
 {
@@ -581,12 +644,12 @@ void LCD::on()  //CHECKED turns on screen
      * LCD memory
      */
     //start write to SPI
-    LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+    select();
     //turn on
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x41);
+    exchangeByte(0xFE); exchangeByte(0x41);
     delay_ms(1);
     //end write to SPI
-    LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+    deselect();
     return;
 }
 void LCD::off() //CHECKED turns off screen
@@ -600,12 +663,12 @@ void LCD::off() //CHECKED turns off screen
      * LCD memory
      */
     //start write to SPI
-    LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+    select();
     //turn off
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x42);
+    exchangeByte(0xFE); exchangeByte(0x42);
     delay_ms(1);
     //end write to SPI
-    LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+    deselect();
     return;
 }
 void LCD::clear()   //CHECKED clears the screen
@@ -621,12 +684,12 @@ void LCD::clear()   //CHECKED clears the screen
      * erased from memory.
      */
     //start write to SPI
-    LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+    select();
     //turn clear screen
-    spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x51);
+    exchangeByte(0xFE); exchangeByte(0x51);
     delay_ms(2);
     //end write to SPI
-    LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+    deselect();
     return;
 }
 void LCD::clear(unsigned int row)        // CHECKED clears a row
@@ -643,28 +706,28 @@ void LCD::clear(unsigned int row)        // CHECKED clears a row
     if(row>0 && row<=4)
     {
         //start write to SPI
-        LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+        select();
         //set coursor
-        spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45);
+        exchangeByte(0xFE); exchangeByte(0x45);
         switch(row)
         {
-        case 1: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x14); break;
-        case 2: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x54); break;
-        case 3: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x28); break;
-        default:spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x67);
-                spi1_ExchangeByte(' ' ) ;//replace last character in row 4 with blank
-                spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x67); break;
+        case 1: exchangeByte(0xFE); exchangeByte(0x45); exchangeByte(0x14); break;
+        case 2: exchangeByte(0xFE); exchangeByte(0x45); exchangeByte(0x54); break;
+        case 3: exchangeByte(0xFE); exchangeByte(0x45); exchangeByte(0x28); break;
+        default:exchangeByte(0xFE); exchangeByte(0x45); exchangeByte(0x67);
+                exchangeByte(' ' ) ;//replace last character in row 4 with blank
+                exchangeByte(0xFE); exchangeByte(0x45); exchangeByte(0x67); break;
         }
 
         //back space
         for(int i = 0; i<21; i++)
         {
-            spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x4E);
+            exchangeByte(0xFE); exchangeByte(0x4E);
             delay_ms(330);
         }
         delay_ms(3);
         //end write to SPI
-        LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+        deselect();
     }
     return;
 }
@@ -681,13 +744,13 @@ void LCD::B_Light(unsigned int level)    //CHECKED changes backlight brightness
     if(level <=8 )
     {
         //start write to SPI
-        LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+        select();
         //set back light
-        spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x53);
-        spi1_ExchangeByte(level);
+        exchangeByte(0xFE); exchangeByte(0x53);
+        exchangeByte(level);
         delay_ms(1);
         //end write to SPI
-        LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+        deselect();
     }
     return;
 }
@@ -704,13 +767,13 @@ void LCD::Contrast(unsigned int level)   //CHECKED changes screen contrast
     if(level <=50 )
     {
         //start write to SPI
-        LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+        select();
         //set contrast
-        spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x52);
-        spi1_ExchangeByte(level);
+        exchangeByte(0xFE); exchangeByte(0x52);
+        exchangeByte(level);
         delay_ms(1);
         //end write to SPI
-        LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+        deselect();
     }
     return;
 }
@@ -727,22 +790,19 @@ void LCD::write(const char* words, unsigned int row) //writes to a specific row.
     if(row >= 0 && row <4)
     {
         //start write to SPI
-        LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+        select();
         //set position
-        switch(row)
-        {
-            case 1: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x40); break;
-            case 2: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x14);break;
-            case 3: spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x54);break;
-            default:spi1_ExchangeByte(0xFE); spi1_ExchangeByte(0x45); spi1_ExchangeByte(0x00);break;
-        }
+        const unsigned char rowPosition[] = { 0x00, 0x40, 0x14, 0x54 };
+        const unsigned char setPosition[] = { 0xFE, 0x45, rowPosition[row] };
+        transfer(setPosition, sizeof(setPosition));
+
         while(words[i]!='\0' && i<20)
         {
-            spi1_ExchangeByte(words[i]);
             i++;
         }
+        transfer((const unsigned char*)words, i);
         //end write to SPI
-        LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+        deselect();
     }
     return;
 }
@@ -761,14 +821,14 @@ void LCD::write(const char* words)          //writes starting from home position
     clear();
 
     //start write to SPI
-    LPC_GPIO0->FIOSET|= (1<<15); LPC_GPIO0->FIOCLR |= (1<<15);
+    select();
     while(words[i]!='\0' && i<80)
     {
-        spi1_ExchangeByte(words[i++]);
-        //i++;
+        i++;
     }
+    transfer((const unsigned char*)words, i);
     //end write to SPI
-    LPC_GPIO0->FIOSET |= (1<<15); //make pin0.15 output high
+    deselect();
     return;
 }
 //////////////////////////////////////////////////////////////////////////////
@@ -27,4 +27,19 @@ CMD_HANDLER_FUNC(lsHandler);
 /// Handler for "rm" to remove a file
 CMD_HANDLER_FUNC(rmHandler);
 
+/// Handler to benchmark Formatter against printf style formatting
+CMD_HANDLER_FUNC(formatBenchmarkHandler);
+
+/// Handler to show or reset the I2C statistics
+CMD_HANDLER_FUNC(i2cHandler);
+
+/// Handler to benchmark the SPI transfer methods
+CMD_HANDLER_FUNC(spiBenchmarkHandler);
+
+/// Handler to show or reset the profiler probes
+CMD_HANDLER_FUNC(profilerHandler);
+
+/// Handler to benchmark task notifications against a binary semaphore
+CMD_HANDLER_FUNC(notifyBenchmarkHandler);
+
 #endif /* HANDLERS_HPP_ */
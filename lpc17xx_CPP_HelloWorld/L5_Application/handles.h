@@ -24,7 +24,8 @@ extern "C" {
 typedef struct
 {
     struct {
-        const xSemaphoreHandle spi;
+        const xSemaphoreHandle spi;     ///< SPI1 bus mutex (SD Card, Flash Memory)
+        const xSemaphoreHandle ssp0;    ///< SSP0 bus mutex
     }Sem;
 
     struct {
@@ -43,7 +44,7 @@ typedef struct
  */
 inline HandlesType* getHandles()
 {
-    static HandlesType handles = { {xSemaphoreCreateMutex()} };
+    static HandlesType handles = { {xSemaphoreCreateMutex(), xSemaphoreCreateMutex()} };
     return &handles;
 }
 
@@ -20,6 +20,7 @@ int main(void)
    bool header = true;
    str current;
    delay_ms( 200 );     //delay for LCD to initialize
+   LC.init();           //LCD's SPI profile is applied each time it writes
 
    while(1)   //Infinite loop to run program
    {
@@ -33,7 +34,6 @@ int main(void)
        {
            //row 3 buttons
            current=SW.getValueAsString();//get the current switch values
-           LC.init();//prepares register to write to LCD 
            LC.write(current(),2);//writes to rwo 3
            printf("%s\n",SW.getValueAsString());
            for(i=1; i<=8; i++)
@@ -58,11 +58,9 @@ int main(void)
        if(KP.getChar(keys))      //if buttons pressed save value in right
        {
            printf("KP: %s\n",keys);   //prints to stdio
-           LD.setRightDigit(keys[0]);//set right LED to 'right'
-           LD.setLeftDigit(keys[1]);  //set left LED to 'left'
+           LD.setDigits(keys[1], keys[0]);//set left LED to 'left' and right LED to 'right'
            //LCD row 4 keypad
            current = "KP: "; current +=  keys;
-           LC.init();//prepares register to write to LCD
            LC.write(current(),3);//updates row 4
            //saves previous key presses.
            for(i = SAVE-2; i>0; i--)
@@ -75,7 +73,6 @@ int main(void)
        if((SW.getSwitch(8) && SW.getSwitch(1)) || header)
        {
            current = "Trent B. Smith";
-           LC.init();//prepares register to write to LCD
            LC.setup(2,40,true); //sets LCD settings
            LC.write(current(),0);//write name to rown1
            header= false;//prevents repeating
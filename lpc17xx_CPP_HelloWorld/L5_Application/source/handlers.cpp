@@ -5,10 +5,19 @@
 #include "task.h"               // vTaskList()
 
 #include "CommandHandler.hpp"   // CMD_HANDLER_FUNC()
-#include "rtc.h"                // Set and Get System Time
+#include "systime.h"            // Set and Get System Time
 #include "utilities.h"          // printMemoryInfo()
 #include "storage.hpp"          // Get Storage Device instances
 #include "filelogger.hpp"       // Logger class
+#include "format.hpp"           // Formatter
+#include "spi1.h"               // SPI benchmark and its device profile
+#include "gpdma.h"              // gpdma_Malloc()
+#include "I2C0.hpp"             // I2C statistics
+#include "I2C1.hpp"
+#include "I2C2.hpp"
+#include "profiler.hpp"         // Profiler probes
+#include "hwtimer.h"            // Notification benchmark
+#include "memory.h"             // getMemoryInfo()
 
 
 CMD_HANDLER_FUNC(taskListHandler)
@@ -62,14 +71,14 @@ CMD_HANDLER_FUNC(timeHandler)
         time.min   = (int)*cmdParams.getToken();
         time.sec   = (int)*cmdParams.getToken();
 
-        rtc_settime(&time);
+        systime_SetWallTime(&time);
         cmdParams = "get"; // Set to get on purpose to print the time below
     }
 
-    time = rtc_gettime();
-    printf("%02u/%02u/%u  --  %02u:%02u:%02u",
+    const unsigned int micros = systime_GetWallTime(&time);
+    printf("%02u/%02u/%u  --  %02u:%02u:%02u.%06u",
             time.month, time.day, time.year,
-            time.hour, time.min, time.sec);
+            time.hour, time.min, time.sec, micros);
 }
 
 CMD_HANDLER_FUNC(loggerTest)
@@ -87,7 +96,36 @@ CMD_HANDLER_FUNC(loggerTest)
         output = "\nLogged an Error";
     }
     else if(cmdParams == "flush") {
-        FileLogger::getInstance().flush();
+        // Log the pending deferred messages before flushing the file logger
+        DeferredLogger::getInstance().flush();
+    }
+    else if(cmdParams == "stats") {
+        FileLogger& logger = FileLogger::getInstance();
+        output.printf("\nBuffers written: %u, Syncs: %u\n"
+                      "Stalled log calls: %u, Dropped messages: %u, Dropped deferred messages: %u",
+                      logger.getBuffersWritten(), logger.getSyncCount(),
+                      logger.getStalledCount(), logger.getDroppedCount(),
+                      DeferredLogger::getInstance().getDroppedCount());
+    }
+    else if(cmdParams.beginsWith("sync ")) {
+        cmdParams.getToken(" ", true);
+        str* pPolicy = cmdParams.getToken();
+        if(0 == pPolicy) {
+            output = "Use 'log sync buffer', 'log sync periodic <ms>' or 'log sync flush'";
+        }
+        else if(*pPolicy == "buffer") {
+            FileLogger::getInstance().setSyncPolicy(syncEveryBuffer);
+        }
+        else if(*pPolicy == "periodic") {
+            str* pPeriod = cmdParams.getToken();
+            FileLogger::getInstance().setSyncPolicy(syncPeriodically, (0 == pPeriod) ? 1000 : (int)*pPeriod);
+        }
+        else if(*pPolicy == "flush") {
+            FileLogger::getInstance().setSyncPolicy(syncOnFlushOnly);
+        }
+        else {
+            output = "Use 'log sync buffer', 'log sync periodic <ms>' or 'log sync flush'";
+        }
     }
     else {
         output.printf("Invalid parameter: |%s|", cmdParams());
@@ -126,7 +164,7 @@ CMD_HANDLER_FUNC(copyHandler)
 
 CMD_HANDLER_FUNC(readHandler)
 {
-    // If -print was present, we will print the string using putchar()
+    // If -print was present, we will print the file's data to stdout
     bool printToScreen = cmdParams.erase("-print");
     cmdParams.trimStart(" ");
     cmdParams.trimEnd(" ");
@@ -148,9 +186,7 @@ CMD_HANDLER_FUNC(readHandler)
             totalBytesRead += bytesRead;
 
             if(printToScreen) {
-                for(unsigned int i=0; i<bytesRead; i++) {
-                    putchar(buffer[i]);
-                }
+                fwrite(buffer, 1, bytesRead, stdout);
             }
         }
         f_close(&file);
@@ -231,3 +267,240 @@ CMD_HANDLER_FUNC(rmHandler)
 }
 
 
+
+CMD_HANDLER_FUNC(formatBenchmarkHandler)
+{
+    int iterations = (int)cmdParams;
+    if(iterations <= 0) {
+        iterations = 1000;
+    }
+
+    char buffer[64];
+    const int intVal = -12345;
+    const unsigned int hexVal = 0xBEEF;
+    const float floatVal = 98.6f;
+    unsigned int startTime = 0;
+    unsigned int reducedTime = 0, newlibTime = 0, formatterTime = 0;
+
+    /* Same output from all three: "val: -12345 hex: 0000BEEF temp: 98.60" */
+    startTime = xTaskGetTickCount();
+    for(int i = 0; i < iterations; i++) {
+        sprintf(buffer, "val: %i hex: %08X temp: %.2f", intVal, hexVal, floatVal);
+    }
+    reducedTime = xTaskGetTickCount() - startTime;
+
+    /* newlib's integer-only version can't do floats, so use Formatter's float for fairness */
+    startTime = xTaskGetTickCount();
+    for(int i = 0; i < iterations; i++) {
+        sniprintf(buffer, sizeof(buffer), "val: %i hex: %08X temp: %i.%02i",
+                  intVal, hexVal, (int)floatVal, (int)(floatVal * 100) % 100);
+    }
+    newlibTime = xTaskGetTickCount() - startTime;
+
+    startTime = xTaskGetTickCount();
+    for(int i = 0; i < iterations; i++) {
+        BufferFormatter f(buffer, sizeof(buffer));
+        f << "val: " << intVal << " hex: " << FmtHex(hexVal, 8) << " temp: " << FmtFixed(floatVal, 2);
+    }
+    formatterTime = xTaskGetTickCount() - startTime;
+
+    printf("Output: %s\n", buffer);
+    printf("%i iterations: reduced sprintf: %u ms, sniprintf: %u ms, Formatter: %u ms\n",
+            iterations, reducedTime, newlibTime, formatterTime);
+}
+
+CMD_HANDLER_FUNC(i2cHandler)
+{
+    // Use I2C2 by default since it is the bus used by the on-board devices
+    int busNum = 2;
+    if(cmdParams.beginsWith("0") || cmdParams.beginsWith("1")) {
+        busNum = cmdParams.c_str()[0] - '0';
+    }
+
+    I2C_Base* pI2C = (0 == busNum) ? (I2C_Base*) &I2C0::getInstance() :
+                     (1 == busNum) ? (I2C_Base*) &I2C1::getInstance() :
+                                     (I2C_Base*) &I2C2::getInstance();
+
+    if(cmdParams.contains("reset")) {
+        pI2C->resetStats();
+        output.printf("I2C%i statistics reset", busNum);
+    }
+    else {
+        const I2C_Stats s = pI2C->getStats();
+        output.printf("I2C%i: %u transactions, %u errors\n"
+                      "  NACKs: %u, Timeouts: %u, Arbitration lost: %u, Bus errors: %u, Bus recoveries: %u\n"
+                      "  Latency: last %u us, max %u us.  Max bus time: %u us\n"
+                      "  Slave window: %u bytes, read %u times",
+                      busNum, s.transactions, s.errors,
+                      s.nacks, s.timeouts, s.arbitrationLost, s.busErrors, s.busRecoveries,
+                      s.lastLatencyUs, s.maxLatencyUs, s.maxBusTimeUs,
+                      pI2C->getSlaveWindowSize(), s.slaveReads);
+    }
+}
+
+CMD_HANDLER_FUNC(spiBenchmarkHandler)
+{
+    const unsigned int maxBytes = 512;
+    static unsigned short buffer16[maxBytes / 2];   // Aligned for 16-bit transfers
+    unsigned char* buffer = (unsigned char*) buffer16;
+    static unsigned char* pDmaBuffer = (unsigned char*) gpdma_Malloc(maxBytes);
+
+    str* pBytes = cmdParams.getToken(" ", true);
+    str* pIterations = cmdParams.getToken();
+    unsigned int bytes = (0 == pBytes) ? 0 : (int)*pBytes;
+    int iterations = (0 == pIterations) ? 0 : (int)*pIterations;
+    if(0 == bytes || bytes > maxBytes) {
+        bytes = maxBytes;
+    }
+    if(iterations <= 0) {
+        iterations = 100;
+    }
+    unsigned int startTime = 0;
+    unsigned int byteTime = 0, fifoTime = 0, fifo16Time = 0, dmaTime = 0, dmaAhbTime = 0;
+
+    /**
+     * Profile of the benchmark so the SSP doesn't run with the clock and mode of its last user.
+     * There is no chip-select, so the data only goes out on the bus.
+     */
+    const unsigned int clockKhz = 24 * 1000;
+    static spi1_Device benchDevice;
+    if(0 == benchDevice.cr0) {
+        benchDevice.mode = 0;
+        spi1_ComputeDeviceProfile(&benchDevice, clockKhz);
+    }
+
+    spi1_Acquire(&benchDevice);
+    {
+        startTime = xTaskGetTickCount();
+        for(int i = 0; i < iterations; i++) {
+            for(unsigned int b = 0; b < bytes; b++) {
+                buffer[b] = spi1_ExchangeByte(buffer[b]);
+            }
+        }
+        byteTime = xTaskGetTickCount() - startTime;
+
+        startTime = xTaskGetTickCount();
+        for(int i = 0; i < iterations; i++) {
+            spi1_Transfer(buffer, buffer, bytes);
+        }
+        fifoTime = xTaskGetTickCount() - startTime;
+
+        startTime = xTaskGetTickCount();
+        for(int i = 0; i < iterations; i++) {
+            spi1_Transfer16(buffer16, buffer16, bytes / 2);
+        }
+        fifo16Time = xTaskGetTickCount() - startTime;
+
+#if SPI1_USE_DMA
+        startTime = xTaskGetTickCount();
+        for(int i = 0; i < iterations; i++) {
+            spi1_DmaTransfer(buffer, buffer, bytes);
+        }
+        dmaTime = xTaskGetTickCount() - startTime;
+
+        if(0 != pDmaBuffer) {
+            startTime = xTaskGetTickCount();
+            for(int i = 0; i < iterations; i++) {
+                spi1_DmaTransfer(pDmaBuffer, pDmaBuffer, bytes);
+            }
+            dmaAhbTime = xTaskGetTickCount() - startTime;
+        }
+#endif
+    }
+    spi1_Release();
+
+    output.printf("%i x %u bytes at %u Khz: byte exchange: %u ms, FIFO: %u ms, FIFO 16-bit: %u ms, "
+                  "DMA: %u ms, DMA (AHB memory): %u ms",
+                  iterations, bytes, clockKhz, byteTime, fifoTime, fifo16Time, dmaTime, dmaAhbTime);
+}
+
+CMD_HANDLER_FUNC(profilerHandler)
+{
+    if(cmdParams.contains("reset")) {
+        Profiler::resetAll();
+        output.printf("Profiler probes reset");
+    }
+    else {
+        Profiler::printAll();
+    }
+}
+
+/// The task and cycle count used by notifyBenchGive() of the notification benchmark
+static xTaskHandle gNotifyBenchTask = 0;
+static volatile unsigned int gNotifyBenchGiveCycles = 0;
+
+/// Timer callback that gives the semaphore @param pArg, or notifies the task if pArg is NULL
+static void notifyBenchGive(void* pArg)
+{
+    portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+    gNotifyBenchGiveCycles = Profiler::getCycles();
+
+    if(0 != pArg) {
+        xSemaphoreGiveFromISR((xSemaphoreHandle) pArg, &higherPriorityTaskWoken);
+    }
+    else {
+        vTaskNotifyGiveFromISR(gNotifyBenchTask, &higherPriorityTaskWoken);
+    }
+    portEND_SWITCHING_ISR(higherPriorityTaskWoken);
+}
+
+CMD_HANDLER_FUNC(notifyBenchmarkHandler)
+{
+    int iterations = (int)cmdParams;
+    if(iterations <= 0) {
+        iterations = 1000;
+    }
+
+    // The semaphore is created once (semaphores are never deleted), measuring its heap usage
+    static xSemaphoreHandle signal = 0;
+    static unsigned int semaphoreBytes = 0;
+    if(0 == signal) {
+        const unsigned int heapBefore = getMemoryInfo().heapUsed;
+        vSemaphoreCreateBinary(signal);
+        semaphoreBytes = getMemoryInfo().heapUsed - heapBefore;
+    }
+    if(0 == signal) {
+        output.printf("Could not create the semaphore");
+        return;
+    }
+
+    hwtimer_Timer timer;
+    memset(&timer, 0, sizeof(timer));
+    gNotifyBenchTask = xTaskGetCurrentTaskHandle();
+
+    // Time from the give in the timer ISR until this task runs, first with the semaphore, then the notification
+    unsigned int totalCycles[2] = { 0, 0 };
+    unsigned int maxCycles[2] = { 0, 0 };
+    for(int method = 0; method < 2; method++)
+    {
+        const bool useSemaphore = (0 == method);
+        xSemaphoreTake(signal, 0);
+        ulTaskNotifyTake(pdTRUE, 0);
+
+        for(int i = 0; i < iterations; i++)
+        {
+            hwtimer_StartOneShot(&timer, 100, notifyBenchGive, useSemaphore ? (void*) signal : 0);
+            const bool gotIt = useSemaphore ? xSemaphoreTake(signal, OS_MS(100)) :
+                                              (0 != ulTaskNotifyTake(pdTRUE, OS_MS(100)));
+            const unsigned int cycles = Profiler::getCycles() - gNotifyBenchGiveCycles;
+            if(!gotIt) {
+                hwtimer_Stop(&timer);
+                output.printf("Timed out waiting for the %s", useSemaphore ? "semaphore" : "notification");
+                return;
+            }
+
+            totalCycles[method] += cycles;
+            if(cycles > maxCycles[method]) {
+                maxCycles[method] = cycles;
+            }
+        }
+    }
+
+    printf("%i iterations, wake-up latency from the ISR in CPU cycles:\n", iterations);
+    printf("  Semaphore   : mean %u, max %u (%u us)\n", totalCycles[0] / iterations,
+            maxCycles[0], Profiler::cyclesToUs(maxCycles[0]));
+    printf("  Notification: mean %u, max %u (%u us)\n", totalCycles[1] / iterations,
+            maxCycles[1], Profiler::cyclesToUs(maxCycles[1]));
+    printf("RAM: %u bytes of heap per binary semaphore, notifications use %u bytes per task\n",
+            semaphoreBytes, (unsigned int) (sizeof(unsigned long) + sizeof(unsigned char)));
+}
@@ -9,16 +9,18 @@
 #include "filelogger.hpp"
 
 #include "rtc.h"             // RTC init
+#include "systime.h"         // Time service init
+#include "hwtimer.h"         // Timer service init
+#include "rit.h"             // RIT periodic callback
+#include "profiler.hpp"      // Profiler init
 #include "I2C2.hpp"          // I2C1 init
 #include "adc0.h"            // ADC0 init
 #include "spi1.h"            // SPI-1 init
+#include "ssp0.h"            // SSP-0 mutex
 #include "storage.hpp"       // Mount Flash & SD Storage
 #include "io.hpp"
 
 
-typedef void (*voidFuncPtr)(void);
-void setupPeriodicCallBack(voidFuncPtr pFunction, unsigned int timeMs);
-
 bool mountStorage(FileSystemObject& drive, const char* pDescStr);
 void copyLogFileToSDCard();
 bool discoverExternalDevsOnI2C();
@@ -43,7 +45,8 @@ void highLevelInitialize()
      * RTC  : Used by FATFS
      * I2C2 : Used by LED Display, Acceleration Sensor, Temperature Sensor
      * ADC0 : Used by Light Sensor
-     * SPI1 : Used by SD Card & External SPI Flash Memory
+     * SPI1 : Used by SD Card, External SPI Flash Memory & LCD (each applies its own SPI profile)
+     * SSP0 : Initialized by the LCD if LCD_USE_SSP0 is enabled
      */
     rtc_initialize();
     I2C2::getInstance().init(200);
@@ -51,13 +54,29 @@ void highLevelInitialize()
     spi1_Init();
 
     /**
-     * Setup Timer0 so that delay_ms(us) functions will work.
-     * vConfigureTimerForRunTimeStats() is used by FreeRTOS run time statistics.
+     * Setup Timer0 used by the time service and FreeRTOS run time statistics.
      * If FreeRTOS is used, timer will be setup anyway.
-     * If FreeRTOS is not used, call it here to delay_ms(us) functions will work.
+     * If FreeRTOS is not used, call it here so the time service will work.
      */
     vConfigureTimerForRunTimeStats();
 
+    /**
+     * Start the time service that extends Timer0 to a 64-bit microsecond
+     * clock, and caches the RTC time every second for FATFS and the loggers.
+     * Its Timer0 interrupt also wakes up the CPU from the tickless idle sleep.
+     */
+    systime_Init();
+
+    /**
+     * Start Timer2 used by the microsecond timer callbacks and delay_ms(us) functions
+     */
+    hwtimer_Init();
+
+    /**
+     * Enable the DWT cycle counter used by the profiler probes
+     */
+    Profiler::init();
+
     /**
      * Intentional delay here because this gives us some time to
      * close COM Port at Hyperload and Open it at Hercules
@@ -68,11 +87,12 @@ void highLevelInitialize()
      * Install 10ms periodic callback outside of FreeRTOS since we want to support
      * FATFS even if FreeRTOS is not running.
      *
-     * Initialize the SPI Mutex that the DISK IO Layer will use (if FreeRTOS is running),
+     * Initialize the SPI Mutex that SPI devices will use (if FreeRTOS is running),
      * and then try to mount both Flash Storage and SD Card Storage and print their info.
      */
-    setupPeriodicCallBack(sd_timerproc, 10);
-    diskio_initializeSPIMutex((xSemaphoreHandle*) (&getHandles()->Sem.spi) );
+    rit_AddCallback(sd_timerproc, 10);
+    spi1_SetBusMutex(getHandles()->Sem.spi);
+    ssp0_SetBusMutex(getHandles()->Sem.ssp0);
 
     /**
      * If Flash is not mounted, it is probably a new board and the flash is not
@@ -96,9 +116,11 @@ void highLevelInitialize()
     }
 
     /**
-     * SD Card specifications are 24Mhz maximum
+     * Create the deferred logger so its task is ready to drain
+     * the messages logged by ISRs using LOG_xxx_FROM_ISR()
      */
-    spi1_SetMaxClockMhz(24);
+    DeferredLogger::getInstance();
+
     printLine();
 
     /**
@@ -202,41 +224,3 @@ bool initializeBoardIO()
 
     return success;
 }
-
-static voidFuncPtr RIT_TIMER_CALLBACK = 0;
-extern "C"
-{
-    void RIT_IRQHandler()
-    {
-        if(0 != RIT_TIMER_CALLBACK) {
-            RIT_TIMER_CALLBACK();
-        }
-        // Clear Interrupt Flag
-        LPC_RIT->RICTRL |= 1;
-    }
-}
-void setupPeriodicCallBack(voidFuncPtr pFunction, unsigned int timeMs)
-{
-    // Divide by zero guard
-    if(0 == timeMs) {
-        timeMs = 1;
-    }
-
-    // Power up first otherwise writing to RIT will give us Hard Fault
-    LPC_SC->PCONP |= (1 << 16);
-
-    // Enable CLK/1 to simplify RICOMPVAL calculation below
-    LPC_SC->PCLKSEL1 &= ~(3 << 26);
-    LPC_SC->PCLKSEL1 |=  (1 << 26);
-
-    LPC_RIT->RICOUNTER = 0;
-    LPC_RIT->RIMASK = 0;
-    LPC_RIT->RICOMPVAL = getCpuClock() / (1000 / timeMs);
-
-    // Clear timer upon match, and enable timer
-    LPC_RIT->RICTRL = (1 << 1) | (1 << 3);
-
-    // Enable System Interrupt and connect the callback
-    RIT_TIMER_CALLBACK = pFunction;
-    NVIC_EnableIRQ(RIT_IRQn);
-}
@@ -5,7 +5,7 @@
 
 #include "io_functions.h"       // stdio set IO functions
 #include "uart0.hpp"            // Interrupt driven UART0 driver
-#include "utilities.h"          // PRINT_EXECUTION_SPEED()
+#include "profiler.hpp"         // PRINT_EXECUTION_SPEED()
 #include "handlers.hpp"         // Command-line handlers
 #include "io.hpp"               // LED Display API
 
@@ -64,11 +64,15 @@ void switchled(void* p)
 
 void terminalTask(void* p)
 {
-    // Initialize Interrupt driven version of getchar & putchar
+    // Initialize Interrupt driven version of getchar & putchar (using DMA for data transfers)
     UART0& uart0 = UART0::getInstance();
-    uart0.init(38400, 32, 256);
+    uart0.init(38400, 32, 256, true);
     stdio_SetInputCharFunction(uart0.getcharIntrDriven);
     stdio_SetOutputCharFunction(uart0.putcharIntrDriven);
+    stdio_SetOutputWriteFunction(uart0.writeIntrDriven);
+
+    // Buffer our output per line so printf() and putchar() don't hit the UART for each char
+    stdio_EnableTaskLineBuffer(128);
 
     CommandProcessor cmdProcessor;  // Command processor to process command-line commands
     str input(128);                 // string with 128 byte initial length
@@ -77,7 +81,12 @@ void terminalTask(void* p)
     cmdProcessor.addHandler(taskListHandler, "Info",   "Task/CPU Info.  Use 'Info 200' to get CPU during 200ms");
     cmdProcessor.addHandler(memInfoHandler, "meminfo", "Show System Memory Info");
     cmdProcessor.addHandler(timeHandler, "time",       "Use 'time get' to view time, 'time set MM DD YYYY HH MM SS' to set time");
-    cmdProcessor.addHandler(loggerTest, "log",         "Use 'log info', 'log warn', 'log error', 'log flush' for demo");
+    cmdProcessor.addHandler(loggerTest, "log",         "Use 'log info', 'log warn', 'log error', 'log flush', 'log stats', 'log sync <buffer|periodic ms|flush>'");
+    cmdProcessor.addHandler(formatBenchmarkHandler, "fmtbench", "Benchmark text formatting.  Use 'fmtbench 1000' to run 1000 iterations");
+    cmdProcessor.addHandler(spiBenchmarkHandler, "spibench", "Benchmark SPI transfers.  Use 'spibench <bytes> <iterations>', such as 'spibench 512 100'");
+    cmdProcessor.addHandler(profilerHandler, "prof",   "Show cycle timings of the profiler probes.  Use 'prof reset' to reset them");
+    cmdProcessor.addHandler(notifyBenchmarkHandler, "notifybench", "Compare task notification and binary semaphore latency from an ISR.  Ex: 'notifybench 1000'");
+    cmdProcessor.addHandler(i2cHandler, "i2c",         "Show I2C statistics.  Use 'i2c [0|1|2]' to select the bus (2 by default), 'i2c [bus] reset' to reset them");
     // File I/O Handlers:
     cmdProcessor.addHandler(copyHandler, "copy",       "Copy files from/to Flash/SD Card.  Ex: 'copy 0:file.txt 1:file.txt'");
     cmdProcessor.addHandler(lsHandler,   "ls",         "Use 'ls 0:' for Flash, or 'ls 1:' for SD Card");
@@ -102,6 +111,7 @@ void terminalTask(void* p)
         {
             PRINT_EXECUTION_SPEED()
             {
+                PROFILE_SCOPE("terminal cmd");
                 puts(cmdProcessor.handleCommand(input));
             }
         }
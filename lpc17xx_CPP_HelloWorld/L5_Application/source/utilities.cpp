@@ -3,7 +3,7 @@
 
 #include "utilities.h"
 #include "LPC17xx.h"
-#include "sysConfig.h" // TIMER0_US_PER_TICK
+#include "hwtimer.h"   // One-shot timer to wake up the delayed task
 #include "memory.h"
 
 
@@ -11,47 +11,79 @@
 #include "task.h"
 
 
-/**
- * Delays in microseconds
- * @param delayMicroSec The delay in microseconds
- */
-inline void delay_us(unsigned int delayMicroSec)
-{
-    const unsigned int ticksForThisDelay = delayMicroSec / TIMER0_US_PER_TICK;
-    const unsigned int targetTick = LPC_TIM0->TC + ticksForThisDelay;
-
-    // Take care of TC overflow case by allowing TC value to go beyond
-    // targetTick, and then the next loop will handle the rest.
-    if(targetTick < LPC_TIM0->TC) {
-        while(LPC_TIM0->TC > targetTick) {
-            ;
-        }
-    }
+/// The latency from the timer interrupt until the delayed task runs again (calibrated by delay_us())
+static unsigned int mWakeupLatencyUs = DELAY_INITIAL_WAKEUP_US;
 
-    // Wait until the TC value reaches targetTick
-    while(LPC_TIM0->TC < targetTick) {
+/// Spins until the microsecond count of Timer2 reaches @param targetUs
+static void delay_spinUntil(unsigned int targetUs)
+{
+    while ((int) (hwtimer_GetMicros() - targetUs) < 0) {
         ;
     }
 }
 
-/**
- * Delays in milliseconds
- * @param delayMilliSec The delay in milliseconds.
- */
-void delay_ms(unsigned int delayMilliSec)
+/// Timer2 callback that notifies the task that is sleeping in delay_us()
+static void delay_wakeTask(void* pTask)
 {
+    portBASE_TYPE switchRequired = pdFALSE;
+    vTaskNotifyGiveFromISR((xTaskHandle) pTask, &switchRequired);
+    portEND_SWITCHING_ISR(switchRequired);
+}
+
+void delay_us(unsigned int delayMicroSec)
+{
+    hwtimer_Init();
+    const unsigned int startUs = hwtimer_GetMicros();
+    const unsigned int targetUs = startUs + delayMicroSec;
+
     /**
-     * If FreeRTOS is running, we should sleep the calling task instead
-     * of polling using the full CPU.
+     * Only sleep the task if the delay is long enough that the CPU is better used by another
+     * task, and the task can block (not an ISR, and the scheduler isn't stopped or suspended)
      */
-    if(taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+    const unsigned int latencyUs = mWakeupLatencyUs;
+    const bool canSleep = (delayMicroSec >= (DELAY_SPIN_FACTOR * latencyUs) + DELAY_MIN_SPIN_US)
+                          && (0 == (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk))
+                          && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+
+    if (canSleep)
     {
-        vTaskDelay(OS_MS(delayMilliSec));
+        /**
+         * Wake up early by the wake-up latency, and spin the rest of the delay.
+         * Any stale notification is cleared first, and the notification is kept
+         * pending if the timer expires before this task starts waiting for it.
+         */
+        hwtimer_Timer timer = { 0 };
+        const unsigned int wakeUs = targetUs - latencyUs;
+
+        ulTaskNotifyTake(pdTRUE, 0);
+        hwtimer_StartOneShot(&timer, delayMicroSec - latencyUs, delay_wakeTask, xTaskGetCurrentTaskHandle());
+
+        // Another notification (such as from a driver) may wake us up early, so sleep again until wake-up time
+        do {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } while ((int) (hwtimer_GetMicros() - wakeUs) < 0);
+
+        // Timer is on the stack, so stop it in case its interrupt didn't run yet
+        hwtimer_Stop(&timer);
+
+        // Calibrate the wake-up latency by the running average of how late the task woke up
+        const int lateUs = (int) (hwtimer_GetMicros() - wakeUs);
+        if (lateUs >= 0 && lateUs <= DELAY_MAX_WAKEUP_US) {
+            mWakeupLatencyUs = ((3 * latencyUs) + lateUs + 3) / 4;
+        }
     }
-    else
-    {
-        delay_us(1000 * delayMilliSec);
+
+    delay_spinUntil(targetUs);
+}
+
+void delay_ms(unsigned int delayMilliSec)
+{
+    // Delay a second at a time so the microseconds do not overflow
+    while (delayMilliSec > 1000) {
+        delay_us(1000 * 1000);
+        delayMilliSec -= 1000;
     }
+    delay_us(1000 * delayMilliSec);
 }
 
 void printMemoryInfo()
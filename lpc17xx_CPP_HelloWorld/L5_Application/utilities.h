@@ -10,8 +10,23 @@ extern "C" {
 
 
 
+#define DELAY_INITIAL_WAKEUP_US     20  ///< Initial estimate of the wake-up latency of a delayed task
+#define DELAY_MAX_WAKEUP_US         200 ///< Wake-ups later than this (preempted by other tasks) are not used for calibration
+#define DELAY_SPIN_FACTOR           4   ///< Delays less than this many times the wake-up latency spin instead of sleeping
+#define DELAY_MIN_SPIN_US           20  ///< Delays less than this always spin
+
+
+
 /**
- * Delays in microseconds
+ * Delays in microseconds.
+ *
+ * If FreeRTOS is running, the calling task sleeps and a one-shot Timer2 match
+ * (hwtimer.h) notifies it slightly before the delay expires, and the rest of the
+ * delay is spent polling so the delay is accurate to a few microseconds.  The
+ * wake-up latency is calibrated by measuring how late the task actually woke up.
+ *
+ * Short delays, and delays called from an ISR or before FreeRTOS starts, only poll.
+ *
  * @param delayMicroSec The delay in microseconds
  */
 void delay_us(unsigned int delayMicroSec);
@@ -19,6 +34,7 @@ void delay_us(unsigned int delayMicroSec);
 /**
  * Delays in milliseconds
  * @param delayMilliSec The delay in milliseconds.
+ * @see delay_us()
  */
 void delay_ms(unsigned int delayMilliSec);
 
@@ -27,20 +43,6 @@ void delay_ms(unsigned int delayMilliSec);
  */
 void printMemoryInfo();
 
-/**
- * Macro that can be used to print the timing/performance of a block
- * Example:
- * @code
- *      PRINT_EXECUTION_SPEED()
- *      {
- *          // ...
- *      }
- *      // At the end, the time taken between this block will be printed
- * @endcode
- */
-#define PRINT_EXECUTION_SPEED() for(unsigned int __time=xTaskGetTickCount(); __time!=0; \
-                                    printf("   Finished in %u ms\n", (unsigned int)xTaskGetTickCount()-__time),__time=0)
-
 
 
 #ifdef __cplusplus
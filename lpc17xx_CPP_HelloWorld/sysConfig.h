@@ -49,6 +49,21 @@ unsigned int getCpuClock();
 #define UART0_DEFAULT_RATE_BPS    38400	 ///< UART0 is configured at this BPS by Startup Code - before main()
 
 
+/**
+ * Interrupt priorities of the drivers (0-31 with 0 being the highest priority)
+ * Interrupts that use FreeRTOS "FromISR" API must have a priority number equal to
+ * or higher than configMAX_SYSCALL_INTERRUPT_PRIORITY (5) otherwise FreeRTOS
+ * critical sections will not be able to mask them.
+ */
+#define INTR_PRIORITY_DMA         6
+#define INTR_PRIORITY_UART        7
+#define INTR_PRIORITY_I2C         8
+#define INTR_PRIORITY_SYSTIME     9   ///< Timer0 overflow and RTC seconds (systime.h)
+#define INTR_PRIORITY_ADC         4   ///< ADC triggered mode ISR doesn't use FreeRTOS, so it can preempt critical sections
+#define INTR_PRIORITY_HWTIMER     5   ///< Timer2 callbacks (hwtimer.h) have the highest priority that can use FreeRTOS
+#define INTR_PRIORITY_RIT         10  ///< Repetitive Interrupt Timer callbacks (rit.h)
+
+
 
 
 